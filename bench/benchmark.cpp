@@ -0,0 +1,339 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QTimer>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+#include <QtAlgorithms>
+
+#include "benchmark.h"
+#include "qgithubreleaseinstrumentation.h"
+#include "jsonparser.h"
+#include "apiworker.h"
+
+namespace {
+
+const int TIMEOUT = 300000;
+
+double ms(qint64 nsecs) {
+	return static_cast<double>(nsecs) / 1e6;
+}
+
+}
+
+Benchmark::Benchmark(const QUrl &url, int iterations, QTextStream &out) : QObject(),
+	m_url(url), m_iterations(qMax(1, iterations)), m_out(out), m_loop(0L), m_error() {}
+
+Benchmark::~Benchmark() {}
+
+bool Benchmark::run() {
+
+	m_out << "QGitHubReleaseAPI benchmark against " << m_url.toString() << "\n\n";
+	m_out << qSetFieldWidth(20) << left << "measurement" << qSetFieldWidth(8) << right
+		  << "samples" << qSetFieldWidth(12) << "min ms" << "median ms" << "mean ms" << "max ms"
+		  << "MiB/s" << qSetFieldWidth(0) << "\n";
+
+	const bool ok = available() && body() && renderAllBodies() && avatar() && tarBall() &&
+			parse();
+
+	if(!ok) m_out << "\nfailed: " << m_error << "\n";
+
+	const QGitHubReleaseInstrumentation::Snapshot &s(QGitHubReleaseInstrumentation::instance()->
+													 snapshot());
+	const char *phases[] = { "parse", "markdown", "embed images" };
+
+	m_out << "\n" << s.requests << " requests, " << s.failed << " failed, " << s.bytesReceived
+		  << " bytes, " << s.fromCache << " from cache, mean TTFB " << qSetRealNumberPrecision(2)
+		  << fixed << (s.ttfbCount ? static_cast<double>(s.ttfb) / s.ttfbCount : 0.0) << " ms\n";
+
+	for(int i = 0; i < QGitHubReleaseInstrumentation::PHASES; ++i) {
+		m_out << phases[i] << ": " << s.phaseCount[i] << " runs, "
+			  << ms(s.phaseTime[i]) << " ms total\n";
+	}
+
+	m_out.flush();
+
+	return ok;
+}
+
+void Benchmark::failed(const QString &err) {
+
+	m_error = err;
+
+	if(m_loop) m_loop->exit(1);
+}
+
+bool Benchmark::wait(const QObject *o, const char *signal) {
+
+	QEventLoop loop;
+
+	m_loop = &loop;
+	m_error = QString::null;
+
+	QObject::connect(o, signal, &loop, SLOT(quit()));
+	QObject::connect(o, SIGNAL(error(QString)), this, SLOT(failed(QString)));
+	QTimer::singleShot(TIMEOUT, &loop, SLOT(quit()));
+
+	const bool ok = loop.exec() == 0;
+
+	QObject::disconnect(o, SIGNAL(error(QString)), this, SLOT(failed(QString)));
+	m_loop = 0L;
+
+	return ok;
+}
+
+QGitHubReleaseAPI *Benchmark::load() {
+
+	QGitHubReleaseAPI *api = new QGitHubReleaseAPI(m_url, QGitHubReleaseAPI::RAW, true, this);
+
+	if(!wait(api, SIGNAL(available(QGitHubReleaseAPI))) || !api->entries()) {
+		if(m_error.isNull()) m_error = "no release information received";
+		delete api;
+		return 0L;
+	}
+
+	return api;
+}
+
+bool Benchmark::available() {
+
+	QVector<qint64> t;
+
+	for(int i = 0; i < m_iterations; ++i) {
+
+		QElapsedTimer timer;
+		timer.start();
+
+		QGitHubReleaseAPI *api = load();
+
+		if(!api) return false;
+
+		t.append(timer.nsecsElapsed());
+		delete api;
+	}
+
+	report("available()", t);
+
+	return true;
+}
+
+bool Benchmark::body() {
+
+	QVector<qint64> t;
+
+	for(int i = 0; i < m_iterations; ++i) {
+
+		QGitHubReleaseAPI *api = load();
+
+		if(!api) return false;
+
+		QObject::connect(api, SIGNAL(error(QString)), this, SLOT(failed(QString)));
+
+		for(int j = 0; j < api->entries(); ++j) {
+
+			QElapsedTimer timer;
+			timer.start();
+
+			if(api->body(j).isEmpty()) {
+				delete api;
+				return false;
+			}
+
+			t.append(timer.nsecsElapsed());
+		}
+
+		delete api;
+	}
+
+	report("body()", t);
+
+	return true;
+}
+
+bool Benchmark::renderAllBodies() {
+
+	QVector<qint64> t;
+
+	for(int i = 0; i < m_iterations; ++i) {
+
+		QGitHubReleaseAPI *api = load();
+
+		if(!api) return false;
+
+		QElapsedTimer timer;
+		timer.start();
+
+		QTimer::singleShot(0, api, SLOT(renderAllBodies()));
+
+		if(!wait(api, SIGNAL(bodiesRendered()))) {
+			delete api;
+			return false;
+		}
+
+		t.append(timer.nsecsElapsed());
+		delete api;
+	}
+
+	report("renderAllBodies()", t);
+
+	return true;
+}
+
+bool Benchmark::avatar() {
+
+	QVector<qint64> t;
+
+	for(int i = 0; i < m_iterations; ++i) {
+
+		QGitHubReleaseAPI *api = load();
+
+		if(!api) return false;
+
+		for(int j = 0; j < api->entries(); ++j) {
+
+			QElapsedTimer timer;
+			timer.start();
+
+			if(api->avatar(j).isNull()) {
+				m_error = QString("avatar %1 not available").arg(j);
+				delete api;
+				return false;
+			}
+
+			t.append(timer.nsecsElapsed());
+		}
+
+		delete api;
+	}
+
+	report("avatar()", t);
+
+	return true;
+}
+
+bool Benchmark::tarBall() {
+
+	QVector<qint64> t;
+	qint64 bytes = Q_INT64_C(0);
+
+	for(int i = 0; i < m_iterations; ++i) {
+
+		QGitHubReleaseAPI *api = load();
+
+		if(!api) return false;
+
+		QTemporaryFile of;
+
+		QElapsedTimer timer;
+		timer.start();
+
+		const qint64 r = of.open() ? api->tarBall(of, 0) : Q_INT64_C(-1);
+
+		t.append(timer.nsecsElapsed());
+		delete api;
+
+		if(r <= 0) {
+			m_error = of.errorString();
+			return false;
+		}
+
+		bytes += r;
+	}
+
+	report("tarBall(QFile&)", t, bytes);
+
+	return true;
+}
+
+bool Benchmark::parse() {
+
+	const QByteArray &json(FileDownloader::fetch(m_url, "qgithubreleaseapi_bench"));
+
+	if(json.isEmpty()) {
+		m_error = "no release information received";
+		return false;
+	}
+
+	const struct {
+		const char *name;
+		ApiWorker::PARSER parser;
+		JsonParser::ISA isa;
+	} backends[] = {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) || defined(QJSON_FOUND)
+		{ "parseJSon(native)", ApiWorker::NATIVE, JsonParser::SCALAR },
+#endif
+		{ "parseJSon(scalar)", ApiWorker::BUILTIN, JsonParser::SCALAR },
+		{ "parseJSon(sse2)", ApiWorker::BUILTIN, JsonParser::SSE2 },
+		{ "parseJSon(avx2)", ApiWorker::BUILTIN, JsonParser::AVX2 }
+	};
+
+	bool ok = true;
+
+	for(size_t b = 0; ok && b < sizeof(backends) / sizeof(backends[0]); ++b) {
+
+		if(backends[b].isa > JsonParser::detectedIsa()) continue;
+
+		QVector<qint64> t;
+
+		ApiWorker::setParser(backends[b].parser);
+		JsonParser::setIsa(backends[b].isa);
+
+		for(int i = 0; ok && i < m_iterations; ++i) {
+
+			QString err;
+			QElapsedTimer timer;
+			timer.start();
+
+			ok = ApiWorker::parseJSon(json, err).isValid();
+
+			t.append(timer.nsecsElapsed());
+
+			if(!ok) m_error = err;
+		}
+
+		if(ok) report(backends[b].name, t, static_cast<qint64>(json.size()) * t.count());
+	}
+
+	ApiWorker::setParser(ApiWorker::AUTO);
+	JsonParser::setIsa(JsonParser::AVX2);
+
+	return ok;
+}
+
+void Benchmark::report(const char *name, QVector<qint64> t, qint64 bytes) {
+
+	qSort(t);
+
+	qint64 sum = Q_INT64_C(0);
+
+	foreach(qint64 v, t) sum += v;
+
+	m_out << qSetFieldWidth(20) << left << name << qSetFieldWidth(8) << right << t.count()
+		  << qSetRealNumberPrecision(2) << fixed << qSetFieldWidth(12) << ms(t.first())
+		  << ms(t[t.count() / 2]) << ms(sum / t.count()) << ms(t.last());
+
+	if(bytes > 0) {
+		m_out << (static_cast<double>(bytes) / 1048576.0) / (static_cast<double>(sum) / 1e9);
+	} else {
+		m_out << "-";
+	}
+
+	m_out << qSetFieldWidth(0) << "\n";
+}
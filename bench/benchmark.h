@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QVector>
+#include <QTextStream>
+
+#include "qgithubreleaseapi.h"
+
+QT_FORWARD_DECLARE_CLASS(QEventLoop)
+
+/**
+ * End-to-end measurements of the public API
+ *
+ * Every run works on fresh @c QGitHubReleaseAPI instances, thus the caches
+ * of the library don't blur the results.
+ */
+class Benchmark : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(Benchmark)
+public:
+	Benchmark(const QUrl &releasesUrl, int iterations, QTextStream &out);
+	virtual ~Benchmark();
+
+	bool run();
+
+private slots:
+	void failed(const QString &err);
+
+private:
+	bool available();
+	bool body();
+	bool renderAllBodies();
+	bool avatar();
+	bool tarBall();
+	bool parse();
+
+	bool wait(const QObject *o, const char *signal);
+	QGitHubReleaseAPI *load();
+	void report(const char *name, QVector<qint64> nsecs, qint64 bytes = Q_INT64_C(-1));
+
+private:
+	const QUrl m_url;
+	const int m_iterations;
+	QTextStream &m_out;
+	QEventLoop *m_loop;
+	QString m_error;
+};
+
+#endif // BENCHMARK_H
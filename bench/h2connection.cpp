@@ -0,0 +1,704 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QTimer>
+#include <QDateTime>
+#include <QTcpSocket>
+
+#include "h2connection.h"
+#include "stubserver.h"
+
+namespace {
+
+const char PREFACE[]       = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+const int PREFACESIZE      = 24;
+const int TICK             = 10;
+const qint64 DEFAULTWINDOW = Q_INT64_C(65535);
+
+typedef enum { DATA, HEADERS, PRIORITY, RST_STREAM, SETTINGS, PUSH_PROMISE, PING, GOAWAY,
+			   WINDOW_UPDATE, CONTINUATION } FRAMETYPE;
+
+typedef enum { END_STREAM = 0x1, ACK = 0x1, END_HEADERS = 0x4, PADDED = 0x8,
+			   PRIORITY_FLAG = 0x20 } FLAG;
+
+typedef enum { PROTOCOL_ERROR = 0x1, FRAME_SIZE_ERROR = 0x6, COMPRESSION_ERROR = 0x9 } ERRORCODE;
+
+const char *STATICTABLE[61][2] = {
+	{ ":authority", "" },
+	{ ":method", "GET" },
+	{ ":method", "POST" },
+	{ ":path", "/" },
+	{ ":path", "/index.html" },
+	{ ":scheme", "http" },
+	{ ":scheme", "https" },
+	{ ":status", "200" },
+	{ ":status", "204" },
+	{ ":status", "206" },
+	{ ":status", "304" },
+	{ ":status", "400" },
+	{ ":status", "404" },
+	{ ":status", "500" },
+	{ "accept-charset", "" },
+	{ "accept-encoding", "gzip, deflate" },
+	{ "accept-language", "" },
+	{ "accept-ranges", "" },
+	{ "accept", "" },
+	{ "access-control-allow-origin", "" },
+	{ "age", "" },
+	{ "allow", "" },
+	{ "authorization", "" },
+	{ "cache-control", "" },
+	{ "content-disposition", "" },
+	{ "content-encoding", "" },
+	{ "content-language", "" },
+	{ "content-length", "" },
+	{ "content-location", "" },
+	{ "content-range", "" },
+	{ "content-type", "" },
+	{ "cookie", "" },
+	{ "date", "" },
+	{ "etag", "" },
+	{ "expect", "" },
+	{ "expires", "" },
+	{ "from", "" },
+	{ "host", "" },
+	{ "if-match", "" },
+	{ "if-modified-since", "" },
+	{ "if-none-match", "" },
+	{ "if-range", "" },
+	{ "if-unmodified-since", "" },
+	{ "last-modified", "" },
+	{ "link", "" },
+	{ "location", "" },
+	{ "max-forwards", "" },
+	{ "proxy-authenticate", "" },
+	{ "proxy-authorization", "" },
+	{ "range", "" },
+	{ "referer", "" },
+	{ "refresh", "" },
+	{ "retry-after", "" },
+	{ "server", "" },
+	{ "set-cookie", "" },
+	{ "strict-transport-security", "" },
+	{ "transfer-encoding", "" },
+	{ "user-agent", "" },
+	{ "vary", "" },
+	{ "via", "" },
+	{ "www-authenticate", "" }
+};
+
+const quint32 HUFFMANCODES[256] = {
+	0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+	0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+	0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+	0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+	0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+	0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+	0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+	0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+	0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+	0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+	0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+	0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+	0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+	0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+	0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+	0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+	0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+	0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+	0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+	0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+	0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+	0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+	0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+	0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+	0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+	0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+	0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+	0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+	0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+	0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+	0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+	0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee
+};
+
+const uchar HUFFMANLENGTHS[256] = {
+	13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+	28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+	6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+	5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+	13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+	15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+	6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+	20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+	24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+	22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+	21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+	26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+	19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+	20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+	26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26
+};
+
+/**
+ * Canonical decoding tables of the Huffman code of RFC 7541: the codes of a
+ * length are consecutive, thus a code is looked up by its offset
+ */
+struct Huffman {
+
+	Huffman() {
+
+		int n = 0;
+
+		for(int len = 0; len <= 30; ++len) {
+
+			first[len] = index[len] = count[len] = 0;
+
+			for(int sym = 0; sym < 256; ++sym) {
+
+				if(HUFFMANLENGTHS[sym] != len) continue;
+
+				if(!count[len]) {
+					first[len] = HUFFMANCODES[sym];
+					index[len] = n;
+				}
+
+				++count[len];
+				symbols[n++] = static_cast<uchar>(sym);
+			}
+		}
+	}
+
+	int symbol(quint32 code, int len) const {
+		return code - first[len] < static_cast<quint32>(count[len]) ?
+					symbols[index[len] + static_cast<int>(code - first[len])] : -1;
+	}
+
+	quint32 first[31];
+	int index[31];
+	int count[31];
+	uchar symbols[256];
+};
+
+}
+
+Q_GLOBAL_STATIC(Huffman, huffman)
+
+namespace {
+
+bool decodeInt(const uchar *&p, const uchar *end, int prefix, quint32 &v) {
+
+	if(p == end) return false;
+
+	const quint32 mask = (1u << prefix) - 1;
+
+	if((v = *p++ & mask) < mask) return true;
+
+	for(int shift = 0; p != end && shift <= 21; shift += 7) {
+
+		const uchar b = *p++;
+
+		v += static_cast<quint32>(b & 0x7f) << shift;
+
+		if(!(b & 0x80)) return true;
+	}
+
+	return false;
+}
+
+bool decodeHuffman(const uchar *p, quint32 len, QByteArray &out) {
+
+	quint32 code = 0;
+	int bits = 0;
+
+	for(quint32 i = 0; i < len * 8; ++i) {
+
+		code = (code << 1) | ((p[i >> 3] >> (7 - (i & 7))) & 1);
+
+		if(++bits > 30) return false;
+
+		const int sym = bits >= 5 ? huffman()->symbol(code, bits) : -1;
+
+		if(sym != -1) {
+			out.append(static_cast<char>(sym));
+			code = 0;
+			bits = 0;
+		}
+	}
+
+	// the padding is a prefix of EOS, i.e. all ones, and shorter than a byte
+	return bits <= 7 && code == (1u << bits) - 1;
+}
+
+bool decodeString(const uchar *&p, const uchar *end, QByteArray &s) {
+
+	if(p == end) return false;
+
+	const bool huffmanCoded = *p & 0x80;
+	quint32 len;
+
+	if(!decodeInt(p, end, 7, len) || len > static_cast<quint32>(end - p)) return false;
+
+	s.clear();
+
+	if(huffmanCoded) {
+		if(!decodeHuffman(p, len, s)) return false;
+	} else {
+		s = QByteArray(reinterpret_cast<const char *>(p), static_cast<int>(len));
+	}
+
+	p += len;
+
+	return true;
+}
+
+void encodeInt(QByteArray &out, int prefix, uchar bits, quint32 v) {
+
+	const quint32 mask = (1u << prefix) - 1;
+
+	if(v < mask) {
+		out.append(static_cast<char>(bits | v));
+		return;
+	}
+
+	out.append(static_cast<char>(bits | mask));
+
+	for(v -= mask; v >= 0x80; v >>= 7) out.append(static_cast<char>((v & 0x7f) | 0x80));
+
+	out.append(static_cast<char>(v));
+}
+
+/// a literal header field without indexing, with a new name
+void encodeField(QByteArray &out, const QByteArray &name, const QByteArray &value) {
+	out.append('\0');
+	encodeInt(out, 7, 0, static_cast<quint32>(name.size()));
+	out.append(name);
+	encodeInt(out, 7, 0, static_cast<quint32>(value.size()));
+	out.append(value);
+}
+
+quint32 uint32At(const QByteArray &ba, int pos) {
+
+	const uchar *p = reinterpret_cast<const uchar *>(ba.constData()) + pos;
+
+	return (static_cast<quint32>(p[0]) << 24) | (static_cast<quint32>(p[1]) << 16) |
+			(static_cast<quint32>(p[2]) << 8) | p[3];
+}
+
+}
+
+StubH2Connection::Stream::Stream() : headerBlock(), headers(), body(), sent(0),
+	readyAt(Q_INT64_C(0)), window(DEFAULTWINDOW), prepared(false), headersSent(false) {}
+
+StubH2Connection::StubH2Connection(QTcpSocket *s, const StubServer &srv, const QByteArray &in,
+								   const QByteArray &upgrade) : QObject(s), m_socket(s),
+	m_server(srv), m_tick(new QTimer(this)), m_in(in), m_preface(false), m_streams(),
+	m_continuation(0), m_lastStream(0), m_window(DEFAULTWINDOW), m_initialWindow(DEFAULTWINDOW),
+	m_maxFrame(16384), m_table(), m_tableSize(0), m_maxTableSize(4096) {
+
+	m_tick->setInterval(TICK);
+
+	QObject::connect(m_socket, SIGNAL(readyRead()), this, SLOT(readFrames()));
+	QObject::connect(m_tick, SIGNAL(timeout()), this, SLOT(sendData()));
+
+	// MAX_CONCURRENT_STREAMS 100
+	frame(SETTINGS, 0, 0, QByteArray("\x00\x03\x00\x00\x00\x64", 6));
+
+	if(!upgrade.isEmpty()) {
+
+		const QList<QByteArray> &lines(upgrade.split('\n'));
+		const QList<QByteArray> &req(lines.first().trimmed().split(' '));
+
+		QByteArray eTag;
+		bool deflate = false;
+
+		foreach(const QByteArray &l, lines) {
+			if(l.toLower().startsWith("if-none-match:")) eTag = l.mid(14).trimmed();
+			if(l.toLower().startsWith("accept-encoding:")) deflate = l.contains("deflate");
+		}
+
+		// the upgraded request is stream 1, half closed already
+		m_lastStream = 1;
+		prepare(1, req.count() > 1 ? req[1] : QByteArray("/"), eTag, deflate);
+	}
+
+	readFrames();
+}
+
+StubH2Connection::~StubH2Connection() {}
+
+void StubH2Connection::frame(uchar type, uchar flags, quint32 id, const QByteArray &payload) {
+
+	QByteArray f;
+
+	const int len = payload.size();
+
+	f.append(static_cast<char>(len >> 16)).append(static_cast<char>(len >> 8)).
+			append(static_cast<char>(len));
+	f.append(static_cast<char>(type)).append(static_cast<char>(flags));
+	f.append(static_cast<char>(id >> 24)).append(static_cast<char>(id >> 16)).
+			append(static_cast<char>(id >> 8)).append(static_cast<char>(id));
+
+	m_socket->write(f.append(payload));
+}
+
+void StubH2Connection::goAway(quint32 error) {
+
+	QByteArray p;
+
+	for(int i = 24; i >= 0; i -= 8) p.append(static_cast<char>(m_lastStream >> i));
+	for(int i = 24; i >= 0; i -= 8) p.append(static_cast<char>(error >> i));
+
+	frame(GOAWAY, 0, 0, p);
+
+	m_tick->stop();
+	m_socket->disconnectFromHost();
+}
+
+void StubH2Connection::readFrames() {
+
+	m_in.append(m_socket->readAll());
+
+	if(!m_preface) {
+
+		if(m_in.size() < PREFACESIZE) return;
+
+		if(!m_in.startsWith(QByteArray(PREFACE, PREFACESIZE))) {
+			goAway(PROTOCOL_ERROR);
+			return;
+		}
+
+		m_in.remove(0, PREFACESIZE);
+		m_preface = true;
+	}
+
+	while(m_in.size() >= 9 && m_socket->state() == QAbstractSocket::ConnectedState) {
+
+		const uchar *h = reinterpret_cast<const uchar *>(m_in.constData());
+		const int len = (h[0] << 16) | (h[1] << 8) | h[2];
+
+		if(len > m_maxFrame && len > 16384) {
+			goAway(FRAME_SIZE_ERROR);
+			return;
+		}
+
+		if(m_in.size() < 9 + len) break;
+
+		const uchar type = h[3], flags = h[4];
+		const quint32 id = uint32At(m_in, 5) & 0x7fffffff;
+		const QByteArray payload(m_in.mid(9, len));
+
+		m_in.remove(0, 9 + len);
+
+		if(!handle(type, flags, id, payload)) {
+			goAway(PROTOCOL_ERROR);
+			return;
+		}
+	}
+}
+
+bool StubH2Connection::handle(uchar type, uchar flags, quint32 id, const QByteArray &payload) {
+
+	// a header block must not be interrupted
+	if(m_continuation && type != CONTINUATION) return false;
+
+	switch(type) {
+	case HEADERS: {
+
+		if(!id || (id & 1) == 0) return false;
+
+		m_lastStream = qMax(m_lastStream, id);
+
+		int start = 0, end = payload.size();
+
+		if(flags & PADDED) {
+			if(payload.isEmpty()) return false;
+			end -= static_cast<uchar>(payload[0]);
+			start = 1;
+		}
+
+		if(flags & PRIORITY_FLAG) start += 5;
+
+		if(start > end) return false;
+
+		m_streams[id].headerBlock = payload.mid(start, end - start);
+
+		if(!(flags & END_HEADERS)) {
+			m_continuation = id;
+			return true;
+		}
+
+		return request(id);
+	}
+	case CONTINUATION:
+
+		if(!m_continuation || id != m_continuation) return false;
+
+		m_streams[id].headerBlock.append(payload);
+
+		if(!(flags & END_HEADERS)) return true;
+
+		m_continuation = 0;
+		return request(id);
+
+	case SETTINGS:
+
+		if(flags & ACK) return true;
+
+		if(id || payload.size() % 6) return false;
+
+		for(int i = 0; i < payload.size(); i += 6) {
+
+			const int key = (static_cast<uchar>(payload[i]) << 8) |
+					static_cast<uchar>(payload[i + 1]);
+			const quint32 value = uint32At(payload, i + 2);
+
+			if(key == 0x4) {
+
+				// applies to the windows of the open streams as well
+				for(QMap<quint32, Stream>::iterator s(m_streams.begin()); s != m_streams.end();
+						++s) {
+					s->window += static_cast<qint64>(value) - m_initialWindow;
+				}
+
+				m_initialWindow = value;
+
+			} else if(key == 0x5) {
+				m_maxFrame = static_cast<int>(qBound(16384u, value, 16777215u));
+			}
+		}
+
+		frame(SETTINGS, ACK, 0, QByteArray());
+		sendData();
+		return true;
+
+	case PING:
+
+		if(!(flags & ACK)) frame(PING, ACK, 0, payload);
+		return true;
+
+	case WINDOW_UPDATE:
+
+		if(payload.size() != 4) return false;
+
+		if(id) {
+			if(m_streams.contains(id)) m_streams[id].window += uint32At(payload, 0) & 0x7fffffff;
+		} else {
+			m_window += uint32At(payload, 0) & 0x7fffffff;
+		}
+
+		sendData();
+		return true;
+
+	case RST_STREAM:
+		m_streams.remove(id);
+		return true;
+
+	case GOAWAY:
+		m_tick->stop();
+		m_socket->disconnectFromHost();
+		return true;
+
+	default: // DATA of a GET, PRIORITY and unknown frames
+		return true;
+	}
+}
+
+bool StubH2Connection::request(quint32 id) {
+
+	QList<HEADER> headers;
+
+	if(!decode(m_streams[id].headerBlock, headers)) {
+		goAway(COMPRESSION_ERROR);
+		return true;
+	}
+
+	QByteArray path("/"), eTag;
+	bool deflate = false;
+
+	foreach(const HEADER &h, headers) {
+		if(h.first == ":path") path = h.second;
+		if(h.first == "if-none-match") eTag = h.second;
+		if(h.first == "accept-encoding") deflate = h.second.contains("deflate");
+	}
+
+	prepare(id, path, eTag, deflate);
+
+	return true;
+}
+
+void StubH2Connection::prepare(quint32 id, const QByteArray &target, const QByteArray &eTag,
+							   bool deflate) {
+
+	// the HTTP/1.1 response, translated
+	const QByteArray &r(m_server.response(target, eTag, deflate));
+	const int sep = r.indexOf("\r\n\r\n");
+	const QList<QByteArray> &lines(r.left(sep).split('\n'));
+
+	Stream &s(m_streams[id]);
+
+	s.headerBlock.clear();
+	encodeField(s.headers, ":status", lines.first().split(' ').value(1));
+
+	for(int i = 1; i < lines.count(); ++i) {
+
+		const int colon = lines[i].indexOf(':');
+		const QByteArray &name(lines[i].left(colon).trimmed().toLower());
+
+		if(colon != -1 && name != "connection") {
+			encodeField(s.headers, name, lines[i].mid(colon + 1).trimmed());
+		}
+	}
+
+	s.body = r.mid(sep + 4);
+	s.window = m_initialWindow;
+	s.readyAt = QDateTime::currentMSecsSinceEpoch() + m_server.config().latency;
+	s.prepared = true;
+
+	if(!m_tick->isActive()) m_tick->start();
+}
+
+void StubH2Connection::sendData() {
+
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	const qint64 budget = m_server.config().bandwidth > 0 ?
+				qMax(Q_INT64_C(1), m_server.config().bandwidth * TICK / 1000) :
+				Q_INT64_C(1) << 30;
+
+	for(QMap<quint32, Stream>::iterator s(m_streams.begin()); s != m_streams.end();) {
+
+		if(!s->prepared || s->readyAt > now) {
+			++s;
+			continue;
+		}
+
+		if(!s->headersSent) {
+			frame(HEADERS, END_HEADERS | (s->body.isEmpty() ? END_STREAM : 0), s.key(),
+				  s->headers);
+			s->headersSent = true;
+		}
+
+		for(qint64 left = budget; s->sent < s->body.size() && left > 0;) {
+
+			const qint64 n = qMin(qMin(left, static_cast<qint64>(m_maxFrame)),
+								  qMin(qMin(m_window, s->window),
+									   static_cast<qint64>(s->body.size() - s->sent)));
+
+			if(n <= 0) break; // waits for a WINDOW_UPDATE
+
+			frame(DATA, s->sent + n == s->body.size() ? END_STREAM : 0, s.key(),
+				  s->body.mid(s->sent, static_cast<int>(n)));
+
+			s->sent += static_cast<int>(n);
+			s->window -= n;
+			m_window -= n;
+			left -= n;
+		}
+
+		if(s->headersSent && s->sent >= s->body.size()) {
+			s = m_streams.erase(s);
+		} else {
+			++s;
+		}
+	}
+
+	bool pending = false;
+
+	foreach(const Stream &s, m_streams) pending = pending || s.prepared;
+
+	if(!pending) m_tick->stop();
+}
+
+bool StubH2Connection::decode(const QByteArray &block, QList<HEADER> &headers) {
+
+	const uchar *p = reinterpret_cast<const uchar *>(block.constData());
+	const uchar *const end = p + block.size();
+
+	while(p < end) {
+
+		const uchar b = *p;
+		quint32 idx;
+		HEADER h;
+
+		if(b & 0x80) { // indexed
+
+			if(!decodeInt(p, end, 7, idx) || !field(idx, h)) return false;
+
+		} else if((b & 0xe0) == 0x20) { // dynamic table size update
+
+			if(!decodeInt(p, end, 5, idx) || idx > 4096) return false;
+
+			m_maxTableSize = static_cast<int>(idx);
+			evict();
+			continue;
+
+		} else { // literal, with incremental indexing or not
+
+			const bool indexing = (b & 0xc0) == 0x40;
+			HEADER named;
+
+			if(!decodeInt(p, end, indexing ? 6 : 4, idx)) return false;
+
+			if(idx) {
+				if(!field(idx, named)) return false;
+				h.first = named.first;
+			} else if(!decodeString(p, end, h.first)) {
+				return false;
+			}
+
+			if(!decodeString(p, end, h.second)) return false;
+
+			if(indexing) insert(h);
+		}
+
+		headers.append(h);
+	}
+
+	return true;
+}
+
+bool StubH2Connection::field(quint32 index, HEADER &header) const {
+
+	if(!index) return false;
+
+	if(index <= 61) {
+		header = HEADER(STATICTABLE[index - 1][0], STATICTABLE[index - 1][1]);
+		return true;
+	}
+
+	if(index - 62 >= static_cast<quint32>(m_table.count())) return false;
+
+	header = m_table[static_cast<int>(index - 62)];
+
+	return true;
+}
+
+void StubH2Connection::insert(const HEADER &header) {
+	m_table.prepend(header);
+	m_tableSize += 32 + header.first.size() + header.second.size();
+	evict();
+}
+
+void StubH2Connection::evict() {
+	while(m_tableSize > m_maxTableSize && !m_table.isEmpty()) {
+		m_tableSize -= 32 + m_table.last().first.size() + m_table.last().second.size();
+		m_table.removeLast();
+	}
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H2CONNECTION_H
+#define H2CONNECTION_H
+
+#include <QMap>
+#include <QPair>
+#include <QObject>
+#include <QByteArray>
+
+QT_FORWARD_DECLARE_CLASS(QTimer)
+QT_FORWARD_DECLARE_CLASS(QTcpSocket)
+
+class StubServer;
+
+/**
+ * An HTTP/2 connection to the stub server
+ *
+ * Entered via ALPN on TLS, with prior knowledge, or by upgrading a cleartext
+ * HTTP/1.1 request. Each stream is answered like an HTTP/1.1 request, with
+ * the latency and bandwidth applied per stream, and under the flow control
+ * windows of the client. Its own header blocks are sent uncompressed.
+ */
+class StubH2Connection : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(StubH2Connection)
+public:
+	typedef QPair<QByteArray, QByteArray> HEADER;
+
+	/**
+	 * @param input the bytes read from @c socket already
+	 * @param upgrade the upgraded request line and headers, answered on stream 1
+	 */
+	StubH2Connection(QTcpSocket *socket, const StubServer &server, const QByteArray &input,
+					 const QByteArray &upgrade = QByteArray());
+	virtual ~StubH2Connection();
+
+private slots:
+	void readFrames();
+	void sendData();
+
+private:
+	struct Stream {
+		Stream();
+
+		QByteArray headerBlock;
+		QByteArray headers;
+		QByteArray body;
+		int sent;
+		qint64 readyAt;
+		qint64 window;
+		bool prepared;
+		bool headersSent;
+	};
+
+	bool handle(uchar type, uchar flags, quint32 id, const QByteArray &payload);
+	bool request(quint32 id);
+	void prepare(quint32 id, const QByteArray &target, const QByteArray &eTag, bool deflate);
+	void frame(uchar type, uchar flags, quint32 id, const QByteArray &payload);
+	void goAway(quint32 error);
+
+	bool decode(const QByteArray &block, QList<HEADER> &headers);
+	bool field(quint32 index, HEADER &header) const;
+	void insert(const HEADER &header);
+	void evict();
+
+private:
+	QTcpSocket *const m_socket;
+	const StubServer &m_server;
+	QTimer *const m_tick;
+	QByteArray m_in;
+	bool m_preface;
+	QMap<quint32, Stream> m_streams;
+	quint32 m_continuation;
+	quint32 m_lastStream;
+	qint64 m_window;
+	qint64 m_initialWindow;
+	int m_maxFrame;
+	QList<HEADER> m_table;
+	int m_tableSize;
+	int m_maxTableSize;
+};
+
+#endif // H2CONNECTION_H
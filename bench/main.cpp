@@ -0,0 +1,205 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QStringList>
+#include <QWaitCondition>
+#include <QCoreApplication>
+
+#include "stubserver.h"
+#include "benchmark.h"
+
+namespace {
+
+/**
+ * Runs the stub server in its own thread, thus it doesn't compete with the
+ * library for the event loop of the benchmark
+ */
+class ServerThread : public QThread {
+public:
+	explicit ServerThread(const StubServer::Config &cnf) : QThread(), m_cnf(cnf), m_mutex(),
+		m_ready(), m_url(), m_started(false) {}
+
+	QUrl startServer() {
+
+		QMutexLocker lock(&m_mutex);
+
+		start();
+
+		while(!m_started) m_ready.wait(&m_mutex);
+
+		return m_url;
+	}
+
+protected:
+	virtual void run() {
+
+		StubServer srv(m_cnf);
+
+		const bool ok = srv.listen(QHostAddress::LocalHost);
+
+		m_mutex.lock();
+		m_url = ok ? srv.releasesUrl() : QUrl();
+		m_started = true;
+		m_ready.wakeAll();
+		m_mutex.unlock();
+
+		if(ok) exec();
+	}
+
+private:
+	const StubServer::Config m_cnf;
+	QMutex m_mutex;
+	QWaitCondition m_ready;
+	QUrl m_url;
+	bool m_started;
+};
+
+/**
+ * Sends the requests for the hosts of recorded fixtures to the stub server
+ */
+QUrl toStubServer(const QUrl &url, void *stub) {
+
+	const QUrl &base(*static_cast<const QUrl *>(stub));
+	QUrl u(url);
+
+	u.setScheme(base.scheme());
+	u.setHost(base.host());
+	u.setPort(base.port());
+
+	return u;
+}
+
+QByteArray readFile(const QString &fileName) {
+
+	QFile f(fileName);
+
+	return f.open(QFile::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+void usage(QTextStream &out) {
+	out << "usage: qgithubreleaseapi_bench [options]\n\n"
+		<< "  --latency <ms>       delay of every response (default 0)\n"
+		<< "  --bandwidth <KiB/s>  throughput limit of every response (default unlimited)\n"
+		<< "  --releases <n>       number of generated releases (default 30)\n"
+		<< "  --tarball <MiB>      size of the generated tarball (default 8)\n"
+		<< "  --iterations <n>     runs per measurement (default 5)\n"
+		<< "  --fixtures <dir>     serve recorded fixtures from <dir> by request path\n"
+		<< "  --cert <pem>         serve HTTPS with this certificate\n"
+		<< "  --key <pem>          private key of the certificate\n"
+		<< "  --no-keep-alive      close every HTTP/1.1 connection after its response\n"
+		<< "  --worker             enable the worker thread mode\n"
+		<< "  --http2              allow HTTP/2 (Qt 5.8 and newer)\n";
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	QCoreApplication app(argc, argv);
+	QTextStream out(stdout);
+
+	StubServer::Config cnf;
+	int iterations = 5;
+	QString cert, key;
+
+	const QStringList &args(app.arguments());
+
+	for(int i = 1; i < args.count(); ++i) {
+
+		const QString &a(args[i]);
+		const QString &v(i + 1 < args.count() ? args[i + 1] : QString::null);
+
+		if(a == "--worker") {
+			QGitHubReleaseAPI::setWorkerThreadEnabled(true);
+			continue;
+		}
+
+		if(a == "--http2") {
+			QGitHubReleaseAPI::setHttp2Enabled(true);
+			continue;
+		}
+
+		if(a == "--no-keep-alive") {
+			cnf.keepAlive = false;
+			continue;
+		}
+
+		if(v.isNull()) {
+			usage(out);
+			return 1;
+		}
+
+		if(a == "--latency") {
+			cnf.latency = v.toInt();
+		} else if(a == "--bandwidth") {
+			cnf.bandwidth = v.toLongLong() * 1024;
+		} else if(a == "--releases") {
+			cnf.releases = v.toInt();
+		} else if(a == "--tarball") {
+			cnf.tarBallSize = v.toLongLong() << 20;
+		} else if(a == "--iterations") {
+			iterations = v.toInt();
+		} else if(a == "--fixtures") {
+			cnf.fixtureDir = v;
+		} else if(a == "--cert") {
+			cert = v;
+		} else if(a == "--key") {
+			key = v;
+		} else {
+			usage(out);
+			return 1;
+		}
+
+		++i;
+	}
+
+	if(!cert.isEmpty()) {
+
+		cnf.certificate = QSslCertificate(readFile(cert));
+		cnf.privateKey  = QSslKey(readFile(key), QSsl::Rsa);
+
+		if(cnf.certificate.isNull() || cnf.privateKey.isNull()) {
+			out << "cannot load certificate " << cert << " or key " << key << "\n";
+			return 1;
+		}
+	}
+
+	ServerThread server(cnf);
+	const QUrl &url(server.startServer());
+
+	if(!url.isValid()) {
+		out << "cannot start the stub server\n";
+		return 1;
+	}
+
+	QUrl stub(url.resolved(QUrl(QLatin1String("/"))));
+
+	// recorded fixtures link to api.github.com, codeload.github.com and the like
+	if(!cnf.fixtureDir.isEmpty()) QGitHubReleaseAPI::setUrlRewriter(toStubServer, &stub);
+
+	const bool ok = Benchmark(url, iterations, out).run();
+
+	server.quit();
+	server.wait();
+
+	return ok ? 0 : 1;
+}
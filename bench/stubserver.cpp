@@ -0,0 +1,371 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QTimer>
+#include <QImage>
+#include <QBuffer>
+#include <QDateTime>
+#include <QSslSocket>
+#include <QStringList>
+
+#include "stubserver.h"
+#include "h2connection.h"
+
+namespace {
+
+const char *REPO    = "/repos/bench/bench";
+const int IMAGES    = 8;
+const int AVATARS   = 4;
+const int TICK      = 10;
+
+const char *PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+QByteArray jsonString(const QString &s) {
+
+	QString e(s);
+
+	e.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+
+	return QByteArray("\"").append(e.toUtf8()).append('"');
+}
+
+}
+
+StubServer::Config::Config() : latency(0), bandwidth(0), releases(30),
+	tarBallSize(Q_INT64_C(8) << 20), fixtureDir(), certificate(), privateKey(),
+	keepAlive(true) {}
+
+StubServer::StubServer(const Config &cnf, QObject *p) : QTcpServer(p), m_cnf(cnf), m_tarBall() {}
+
+StubServer::~StubServer() {}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+void StubServer::incomingConnection(qintptr sd) {
+#else
+void StubServer::incomingConnection(int sd) {
+#endif
+
+	if(isSecure()) {
+
+		QSslSocket *s = new QSslSocket(this);
+
+		if(s->setSocketDescriptor(sd)) {
+			s->setLocalCertificate(m_cnf.certificate);
+			s->setPrivateKey(m_cnf.privateKey);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+			QSslConfiguration c(s->sslConfiguration());
+			c.setAllowedNextProtocols(QList<QByteArray>() << QSslConfiguration::ALPNProtocolHTTP2
+									  << QSslConfiguration::NextProtocolHttp1_1);
+			s->setSslConfiguration(c);
+#endif
+			s->startServerEncryption();
+			new StubConnection(s, *this);
+		} else {
+			delete s;
+		}
+
+	} else {
+
+		QTcpSocket *s = new QTcpSocket(this);
+
+		if(s->setSocketDescriptor(sd)) {
+			new StubConnection(s, *this);
+		} else {
+			delete s;
+		}
+	}
+}
+
+QUrl StubServer::baseUrl() const {
+	return QUrl(QString("%1://127.0.0.1:%2").arg(isSecure() ? "https" : "http").
+				arg(serverPort()));
+}
+
+QUrl StubServer::releasesUrl() const {
+	return QUrl(QString("%1%2/releases?per_page=%3").arg(baseUrl().toString()).
+				arg(QLatin1String(REPO)).arg(m_cnf.releases));
+}
+
+QByteArray StubServer::response(const QByteArray &target, const QByteArray &eTag,
+								bool deflate, bool keepAlive) const {
+
+	const QByteArray path(target.left(target.indexOf('?')));
+	const QByteArray base(baseUrl().toString().toUtf8());
+
+	QByteArray body, type("application/json; charset=utf-8");
+	int status = 200;
+
+	QFile fixture(m_cnf.fixtureDir + QString::fromUtf8(path.constData()));
+
+	if(!m_cnf.fixtureDir.isEmpty() && fixture.open(QFile::ReadOnly)) {
+		body = fixture.readAll().replace("@BASE@", base);
+		if(!path.endsWith("releases") && path != "/emojis") type = "application/octet-stream";
+	} else if(path == QByteArray(REPO).append("/releases")) {
+		body = releases();
+	} else if(path == "/emojis") {
+		body = emojis();
+	} else if(path.startsWith("/images/") || path.startsWith("/avatars/")) {
+		body = image(path.mid(path.lastIndexOf('/') + 1).toInt());
+		type = "image/png";
+	} else if(path.startsWith(QByteArray(REPO).append("/tarball/"))) {
+		body = tarBall();
+		type = "application/x-gzip";
+	} else {
+		body = "{\"message\":\"Not Found\"}";
+		status = 404;
+	}
+
+	const QByteArray tag(QByteArray("\"").append(QByteArray::number(qHash(body), 16)).
+						 append('"'));
+
+	if(status == 200 && !eTag.isEmpty() && eTag == tag) {
+		status = 304;
+		body.clear();
+	}
+
+	// qCompress() yields a zlib stream behind a four byte length prefix
+	deflate = deflate && !body.isEmpty() && type.startsWith("application/json");
+
+	if(deflate) body = qCompress(body).mid(4);
+
+	QByteArray r("HTTP/1.1 ");
+
+	r.append(QByteArray::number(status)).append(status == 200 ? " OK" : status == 304 ?
+													 " Not Modified" : " Not Found");
+	r.append("\r\nContent-Type: ").append(type);
+	r.append("\r\nContent-Length: ").append(QByteArray::number(body.size()));
+	if(deflate) r.append("\r\nContent-Encoding: deflate");
+	r.append("\r\nETag: ").append(tag);
+	r.append("\r\nX-RateLimit-Limit: 5000\r\nX-RateLimit-Remaining: 4999");
+	r.append("\r\nX-RateLimit-Reset: ").append(QByteArray::number(QDateTime::currentDateTime().
+																  addSecs(3600).toTime_t()));
+	r.append(keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+
+	return r.append(body);
+}
+
+QByteArray StubServer::releases() const {
+
+	const QString base(baseUrl().toString());
+	const QString repo(base + QLatin1String(REPO));
+	const QDateTime epoch(QDate(2015, 1, 1), QTime(12, 0), Qt::UTC);
+
+	QByteArray json("[");
+
+	for(int i = 0; i < m_cnf.releases; ++i) {
+
+		const int n = m_cnf.releases - i;
+		const QString tag(QString("V1.%1.0").arg(n));
+		const QString rel(QString("%1/releases/%2").arg(repo).arg(n));
+		const QString img(QString("%1/images/%2.png").arg(base).arg(n % IMAGES));
+		const QString date(epoch.addDays(n * 7).toString("yyyy-MM-dd'T'hh:mm:ss'Z'"));
+
+		QString md(QString("## Release %1\n\n").arg(tag)), html(QString("<h2>Release %1</h2>\n"
+																		 "<ul>\n").arg(tag));
+
+		for(int j = 0; j < 20; ++j) {
+			md.append(QString("* fixed *issue* #%1 in `module%2`\n").arg(n * 100 + j).arg(j));
+			html.append(QString("<li>fixed <em>issue</em> #%1 in <code>module%2</code></li>\n").
+						arg(n * 100 + j).arg(j));
+		}
+
+		md.append(QString("\n![screenshot](%1)\n").arg(img));
+		html.append(QString("</ul>\n<p><img src=\"%1\" alt=\"screenshot\"></p>\n").arg(img));
+
+		if(i) json.append(',');
+
+		json.append("{\"url\":").append(jsonString(rel));
+		json.append(",\"assets_url\":").append(jsonString(rel + "/assets"));
+		json.append(",\"upload_url\":").append(jsonString(rel + "/assets{?name}"));
+		json.append(",\"html_url\":").append(jsonString(base + "/bench/bench/releases/tag/" +
+														tag));
+		json.append(",\"id\":").append(QByteArray::number(1000000 + n));
+		json.append(",\"tag_name\":").append(jsonString(tag));
+		json.append(",\"target_commitish\":\"master\"");
+		json.append(",\"name\":").append(jsonString("Release " + tag));
+		json.append(",\"draft\":false,\"prerelease\":").append(n % 5 ? "false" : "true");
+		json.append(",\"created_at\":").append(jsonString(date));
+		json.append(",\"published_at\":").append(jsonString(date));
+		json.append(",\"author\":{\"login\":\"bench\",\"id\":").
+				append(QByteArray::number(n % AVATARS));
+		json.append(",\"avatar_url\":").append(jsonString(QString("%1/avatars/%2").arg(base).
+														  arg(n % AVATARS)));
+		json.append(",\"html_url\":").append(jsonString(base + "/bench")).append('}');
+		json.append(",\"tarball_url\":").append(jsonString(repo + "/tarball/" + tag));
+		json.append(",\"zipball_url\":").append(jsonString(repo + "/zipball/" + tag));
+		json.append(",\"body\":").append(jsonString(md));
+		json.append(",\"body_html\":").append(jsonString(html));
+		json.append(",\"body_text\":").append(jsonString(md)).append('}');
+	}
+
+	return json.append(']');
+}
+
+QByteArray StubServer::emojis() const {
+
+	const QString base(baseUrl().toString());
+	const char *keys[] = { "+1", "smile", "tada", "bug", "rocket", "warning" };
+
+	QByteArray json("{");
+
+	for(int i = 0; i < static_cast<int>(sizeof(keys)/sizeof(keys[0])); ++i) {
+		if(i) json.append(',');
+		json.append(jsonString(keys[i])).append(':').
+				append(jsonString(QString("%1/images/%2.png").arg(base).arg(i % IMAGES)));
+	}
+
+	return json.append('}');
+}
+
+QByteArray StubServer::image(int n) const {
+
+	QImage img(128, 128, QImage::Format_ARGB32);
+	img.fill(qRgb((n * 53) & 0xff, (n * 97) & 0xff, (n * 151) & 0xff));
+
+	QByteArray ba;
+	QBuffer buf(&ba);
+
+	buf.open(QIODevice::WriteOnly);
+	img.save(&buf, "PNG");
+
+	return ba;
+}
+
+QByteArray StubServer::tarBall() const {
+
+	if(m_tarBall.size() != m_cnf.tarBallSize) {
+
+		m_tarBall.resize(static_cast<int>(m_cnf.tarBallSize));
+
+		quint32 x = 2463534242U;
+
+		// xorshift, incompressible like real archive data
+		for(int i = 0; i < m_tarBall.size(); ++i) {
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			m_tarBall[i] = static_cast<char>(x);
+		}
+	}
+
+	return m_tarBall;
+}
+
+StubConnection::StubConnection(QTcpSocket *s, const StubServer &srv) : QObject(s),
+	m_socket(s), m_server(srv), m_throttle(new QTimer(this)), m_request(), m_response(),
+	m_sent(0), m_keepAlive(false) {
+
+	m_throttle->setInterval(TICK);
+
+	QObject::connect(m_socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+	QObject::connect(m_socket, SIGNAL(disconnected()), m_socket, SLOT(deleteLater()));
+	QObject::connect(m_throttle, SIGNAL(timeout()), this, SLOT(sendChunk()));
+}
+
+StubConnection::~StubConnection() {}
+
+void StubConnection::readRequest() {
+
+	m_request.append(m_socket->readAll());
+
+	const QByteArray preface(PREFACE);
+
+	// prior knowledge, or ALPN negotiated h2
+	if(m_response.isEmpty() && preface.startsWith(m_request.left(preface.size()))) {
+		if(m_request.size() >= preface.size()) h2(m_request);
+		return;
+	}
+
+	if(!m_response.isEmpty() || !m_request.contains("\r\n\r\n")) return;
+
+	const int end = m_request.indexOf("\r\n\r\n");
+	const QList<QByteArray> &lines(m_request.left(end).split('\n'));
+	const QList<QByteArray> &req(lines.first().trimmed().split(' '));
+
+	QByteArray eTag;
+	bool deflate = false, upgrade = false;
+
+	m_keepAlive = m_server.config().keepAlive && req.value(2) == "HTTP/1.1";
+
+	foreach(const QByteArray &l, lines) {
+		if(l.toLower().startsWith("if-none-match:")) eTag = l.mid(14).trimmed();
+		if(l.toLower().startsWith("accept-encoding:")) deflate = l.contains("deflate");
+		if(l.toLower().startsWith("upgrade:")) upgrade = l.mid(8).trimmed() == "h2c";
+		if(l.toLower().startsWith("connection:")) m_keepAlive = m_keepAlive &&
+				!l.toLower().contains("close");
+	}
+
+	if(upgrade) {
+		m_socket->write("HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\n"
+						"Upgrade: h2c\r\n\r\n");
+		h2(m_request.mid(end + 4), m_request.left(end));
+		return;
+	}
+
+	m_response = m_server.response(req.count() > 1 ? req[1] : QByteArray("/"), eTag, deflate,
+								   m_keepAlive);
+
+	// the requests are GETs without a body, a pipelined one may follow
+	m_request.remove(0, end + 4);
+
+	QTimer::singleShot(m_server.config().latency, this, SLOT(respond()));
+}
+
+void StubConnection::h2(const QByteArray &input, const QByteArray &upgrade) {
+	m_socket->disconnect(this);
+	new StubH2Connection(m_socket, m_server, input, upgrade);
+	deleteLater();
+}
+
+void StubConnection::respond() {
+
+	if(m_server.config().bandwidth > 0) {
+		m_throttle->start();
+		sendChunk();
+	} else {
+		m_socket->write(m_response);
+		sent();
+	}
+}
+
+void StubConnection::sendChunk() {
+
+	const int chunk = qMax(1, static_cast<int>(m_server.config().bandwidth * TICK / 1000));
+
+	m_sent += static_cast<int>(m_socket->write(m_response.mid(m_sent, chunk)));
+
+	if(m_sent >= m_response.size()) {
+		m_throttle->stop();
+		sent();
+	}
+}
+
+void StubConnection::sent() {
+
+	if(!m_keepAlive) {
+		m_socket->disconnectFromHost();
+		return;
+	}
+
+	m_response.clear();
+	m_sent = 0;
+
+	if(m_request.contains("\r\n\r\n")) readRequest();
+}
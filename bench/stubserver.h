@@ -0,0 +1,128 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STUBSERVER_H
+#define STUBSERVER_H
+
+#include <QTcpServer>
+#include <QSslCertificate>
+#include <QSslKey>
+
+QT_FORWARD_DECLARE_CLASS(QTimer)
+
+/**
+ * Local stand-in for the GitHub API
+ *
+ * Serves the release list, the emoji table, avatars, images and tarballs.
+ * Every response is delayed by @c latency and sent at no more than
+ * @c bandwidth bytes per second. HTTP/1.1 connections are kept alive, unless
+ * @c keepAlive is off, so connection reuse can be measured.
+ *
+ * HTTP/2 is spoken as well, if negotiated via ALPN, with prior knowledge or
+ * after an @c h2c upgrade.
+ *
+ * Fixtures are generated, unless a fixture directory is given. Files found
+ * there by their request path are served verbatim, with @c @@BASE@@ replaced
+ * by the base URL of the server.
+ */
+class StubServer : public QTcpServer {
+	Q_OBJECT
+	Q_DISABLE_COPY(StubServer)
+public:
+	struct Config {
+		Config();
+
+		int latency;
+		qint64 bandwidth;
+		int releases;
+		qint64 tarBallSize;
+		QString fixtureDir;
+		QSslCertificate certificate;
+		QSslKey privateKey;
+		bool keepAlive;
+	};
+
+	explicit StubServer(const Config &cnf, QObject *parent = 0);
+	virtual ~StubServer();
+
+	inline bool isSecure() const {
+		return !m_cnf.certificate.isNull();
+	}
+
+	QUrl baseUrl() const;
+	QUrl releasesUrl() const;
+
+	QByteArray response(const QByteArray &path, const QByteArray &eTag, bool deflate,
+						bool keepAlive = false) const;
+
+	inline const Config &config() const {
+		return m_cnf;
+	}
+
+protected:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+	virtual void incomingConnection(qintptr socketDescriptor);
+#else
+	virtual void incomingConnection(int socketDescriptor);
+#endif
+
+private:
+	QByteArray releases() const;
+	QByteArray emojis() const;
+	QByteArray image(int n) const;
+	QByteArray tarBall() const;
+
+private:
+	const Config m_cnf;
+	mutable QByteArray m_tarBall;
+};
+
+/**
+ * The HTTP exchanges on a stub server connection, one after another
+ */
+class StubConnection : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(StubConnection)
+public:
+	StubConnection(QTcpSocket *socket, const StubServer &server);
+	virtual ~StubConnection();
+
+private slots:
+	void readRequest();
+	void respond();
+	void sendChunk();
+
+private:
+	/// hands the connection over to HTTP/2
+	void h2(const QByteArray &input, const QByteArray &upgrade = QByteArray());
+
+	/// closes the connection, or waits for the next request
+	void sent();
+
+private:
+	QTcpSocket *const m_socket;
+	const StubServer &m_server;
+	QTimer *const m_throttle;
+	QByteArray m_request;
+	QByteArray m_response;
+	int m_sent;
+	bool m_keepAlive;
+};
+
+#endif // STUBSERVER_H
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QCoreApplication>
+
+#include "mirrorserver.h"
+
+namespace {
+
+void usage(QTextStream &out) {
+	out << "usage: qgithubreleaseapi_mirror [options]\n\n"
+		<< "  --listen <address>   address to listen on (default localhost)\n"
+		<< "  --port <n>           port to listen on (default 8080)\n"
+		<< "  --cache <dir>        cache directory (default ./mirror-cache)\n"
+		<< "  --max-age <s>        serve entries without revalidation for <s> seconds"
+		   " (default 60)\n"
+		<< "  --max-cache <MiB>    evict the least recently fetched entries above <MiB>"
+		   " (default 1024, 0 for no limit)\n"
+		<< "  --upstream <url>     API to mirror (default https://api.github.com)\n"
+		<< "  --public-url <url>   URL the clients reach the mirror at (required)\n"
+		<< "  --token-file <file>  authenticate upstream with the token in <file>\n"
+		<< "  --http2              allow HTTP/2 upstream (Qt 5.8 and newer)\n\n"
+		<< "Point the clients at the mirror with QGitHubReleaseAPI::setApiBaseUrl.\n";
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	QCoreApplication app(argc, argv);
+	QTextStream out(stdout);
+
+	MirrorServer::Config cnf;
+	QHostAddress address(QHostAddress::LocalHost);
+	quint16 port = 8080;
+
+	cnf.cacheDir = QDir::current().filePath("mirror-cache");
+
+	const QStringList &args(app.arguments());
+
+	for(int i = 1; i < args.count(); ++i) {
+
+		const QString &a(args[i]);
+		const QString &v(i + 1 < args.count() ? args[i + 1] : QString::null);
+
+		if(a == "--http2") {
+			QGitHubReleaseAPI::setHttp2Enabled(true);
+			continue;
+		}
+
+		if(v.isNull()) {
+			usage(out);
+			return 1;
+		}
+
+		if(a == "--listen") {
+			address = QHostAddress(v);
+		} else if(a == "--port") {
+			port = static_cast<quint16>(v.toUInt());
+		} else if(a == "--cache") {
+			cnf.cacheDir = v;
+		} else if(a == "--max-age") {
+			cnf.maxAge = v.toInt();
+		} else if(a == "--max-cache") {
+			cnf.maxCacheSize = v.toLongLong() << 20;
+		} else if(a == "--upstream") {
+			cnf.upstream = QUrl(v);
+		} else if(a == "--public-url") {
+			cnf.publicUrl = QUrl(v);
+		} else if(a == "--token-file") {
+
+			QFile f(v);
+
+			if(!f.open(QFile::ReadOnly)) {
+				out << "cannot read " << v << ": " << f.errorString() << "\n";
+				return 1;
+			}
+
+			cnf.token = f.readAll().trimmed();
+
+		} else {
+			usage(out);
+			return 1;
+		}
+
+		++i;
+	}
+
+	// links taken from Host would point wherever a client claims
+	if(!cnf.publicUrl.isValid() || cnf.publicUrl.isRelative()) {
+		usage(out);
+		return 1;
+	}
+
+	MirrorServer srv(cnf);
+
+	if(!srv.listen(address, port)) {
+		out << "cannot listen on port " << port << ": " << srv.errorString() << "\n";
+		return 1;
+	}
+
+	out << "mirroring " << cnf.upstream.toString() << " on port " << srv.serverPort()
+		<< ", caching in " << cnf.cacheDir << endl;
+
+	return app.exec();
+}
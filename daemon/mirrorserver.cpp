@@ -0,0 +1,573 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QRegExp>
+#include <QDateTime>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+#include "mirrorserver.h"
+#include "filesink.h"
+
+namespace {
+
+const char *USERAGENT   = "qgithubreleaseapi_mirror";
+const quint16 METAVERSION = 1;
+const qint64 CHUNK      = Q_INT64_C(65536);
+
+QByteArray stripSlash(const QUrl &url) {
+
+	QByteArray s(url.toEncoded());
+
+	while(s.endsWith('/')) s.chop(1);
+
+	return s;
+}
+
+QByteArray jsonMessage(const QString &msg) {
+
+	QString e(msg);
+
+	e.replace('\\', "\\\\").replace('"', "\\\"");
+
+	return QByteArray("{\"message\":\"").append(e.toUtf8()).append("\"}");
+}
+
+const char *reason(int status) {
+
+	switch(status) {
+	case 200: return "OK";
+	case 304: return "Not Modified";
+	case 400: return "Bad Request";
+	case 403: return "Forbidden";
+	case 404: return "Not Found";
+	case 405: return "Method Not Allowed";
+	case 502: return "Bad Gateway";
+	default:  return status < 300 ? "OK" : status < 500 ? "Client Error" : "Server Error";
+	}
+}
+
+inline bool isSuccess(int status) {
+	return status >= 200 && status <= 299;
+}
+
+/// the release endpoints only, the token must not open anything else to the LAN
+bool isMirrored(const QString &path) {
+	return QRegExp("/repos/[^/]+/[^/]+/(releases(/latest|/tags/.+|/assets/[0-9]+)?|"
+				   "(tarball|zipball)/.+)|/emojis").exactMatch(path);
+}
+
+}
+
+struct MirrorServer::Fetch {
+	Fetch(const QByteArray &k, const QUrl &url, const Entry &e) : key(k), old(e),
+		dl(new FileDownloader(url, USERAGENT, QString::fromLatin1(e.eTag.constData()))),
+		reply(0L), sink(0L), errorBody(), broken(false), waiting() {}
+
+	~Fetch() {
+		delete sink;
+		dl->deleteLater();
+	}
+
+	const QByteArray key;
+	const Entry old;
+	FileDownloader *const dl;
+	QNetworkReply *reply;
+	FileSink *sink;
+	QByteArray errorBody;
+	bool broken;
+	QList<MirrorConnection *> waiting;
+};
+
+MirrorServer::Config::Config() : upstream(QUrl(QLatin1String("https://api.github.com"))),
+	cacheDir(), maxAge(60), maxCacheSize(Q_INT64_C(1) << 30), token(), publicUrl() {}
+
+MirrorServer::Entry::Entry() : status(0), contentType(), eTag(), lastModified(),
+	fetched(Q_INT64_C(0)) {}
+
+MirrorServer::MirrorServer(const Config &cnf, QObject *p) : QTcpServer(p), m_cnf(cnf),
+	m_entries(), m_fetches(), m_senders() {
+	QDir().mkpath(m_cnf.cacheDir);
+	evict();
+}
+
+MirrorServer::~MirrorServer() {
+	qDeleteAll(m_fetches);
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+void MirrorServer::incomingConnection(qintptr sd) {
+#else
+void MirrorServer::incomingConnection(int sd) {
+#endif
+
+	QTcpSocket *s = new QTcpSocket(this);
+
+	if(s->setSocketDescriptor(sd)) {
+		new MirrorConnection(s, *this);
+	} else {
+		delete s;
+	}
+}
+
+QString MirrorServer::bodyFile(const QByteArray &key) const {
+	return QDir(m_cnf.cacheDir).filePath(QString::fromLatin1(key.constData()) + ".body");
+}
+
+MirrorServer::Entry MirrorServer::entry(const QByteArray &key) {
+
+	QHash<QByteArray, Entry>::const_iterator i(m_entries.constFind(key));
+
+	if(i != m_entries.constEnd()) return *i;
+
+	Entry e;
+	QFile meta(QDir(m_cnf.cacheDir).filePath(QString::fromLatin1(key.constData()) + ".meta"));
+
+	// left by a previous run
+	if(meta.open(QIODevice::ReadOnly) && QFile::exists(bodyFile(key))) {
+
+		QDataStream ds(&meta);
+		quint16 version = 0;
+
+		ds >> version;
+
+		if(version == METAVERSION) {
+			ds >> e.status >> e.contentType >> e.eTag >> e.lastModified >> e.fetched;
+			if(ds.status() != QDataStream::Ok) e = Entry();
+		}
+	}
+
+	return m_entries[key] = e;
+}
+
+bool MirrorServer::store(const QByteArray &key, const Entry &e) {
+
+	FileSink sink(QDir(m_cnf.cacheDir).filePath(QString::fromLatin1(key.constData()) + ".meta"));
+
+	m_entries[key] = e;
+
+	if(!sink.open(QIODevice::WriteOnly)) return false;
+
+	QDataStream ds(&sink);
+
+	ds << METAVERSION << e.status << e.contentType << e.eTag << e.lastModified << e.fetched;
+
+	return ds.status() == QDataStream::Ok && sink.commit();
+}
+
+void MirrorServer::evict() {
+
+	if(m_cnf.maxCacheSize <= Q_INT64_C(0)) return;
+
+	// a revalidation rewrites the meta file only, thus it tells the last fetch
+	const QFileInfoList &metas(QDir(m_cnf.cacheDir).entryInfoList(QStringList("*.meta"),
+																	QDir::Files,
+																	QDir::Time|QDir::Reversed));
+	QList<qint64> sizes;
+	qint64 total = Q_INT64_C(0);
+
+	foreach(const QFileInfo &m, metas) {
+		sizes.append(QFileInfo(bodyFile(m.completeBaseName().toLatin1())).size());
+		total += sizes.last();
+	}
+
+	for(int i = 0; total > m_cnf.maxCacheSize && i < metas.count(); ++i) {
+
+		const QByteArray &key(metas[i].completeBaseName().toLatin1());
+
+		// still being fetched
+		if(m_fetches.contains(key)) continue;
+
+		// the body may be in use on Windows, a later eviction gets it
+		if(QFile::remove(bodyFile(key)) || !QFile::exists(bodyFile(key))) {
+			QFile::remove(metas[i].filePath());
+			m_entries.remove(key);
+			total -= sizes[i];
+		}
+	}
+}
+
+void MirrorServer::request(MirrorConnection *c, const QByteArray &target,
+						   const QByteArray &accept) {
+
+	const QByteArray key(QCryptographicHash::hash(QByteArray(accept).append('\n').append(target),
+												  QCryptographicHash::Sha1).toHex());
+
+	QHash<QByteArray, Fetch *>::const_iterator i(m_fetches.constFind(key));
+
+	// somebody asked for it already
+	if(i != m_fetches.constEnd()) {
+		(*i)->waiting.append(c);
+		return;
+	}
+
+	const Entry &e(entry(key));
+
+	if(e.isValid() && QDateTime::currentMSecsSinceEpoch() - e.fetched <
+			static_cast<qint64>(m_cnf.maxAge) * 1000) {
+		c->serve(key, e, "HIT");
+		return;
+	}
+
+	Fetch *f = new Fetch(key, QUrl::fromEncoded(stripSlash(m_cnf.upstream) + target), e);
+
+	f->waiting.append(c);
+	f->dl->setToken(m_cnf.token);
+
+	m_fetches.insert(key, f);
+	m_senders.insert(f->dl, f);
+
+	QObject::connect(f->dl, SIGNAL(replyChanged(QNetworkReply*)),
+					 this, SLOT(updateReply(QNetworkReply*)));
+	QObject::connect(f->dl, SIGNAL(downloaded(FileDownloader)),
+					 this, SLOT(downloaded(FileDownloader)));
+	QObject::connect(f->dl, SIGNAL(error(QString)), this, SLOT(failed(QString)));
+
+	QNetworkReply *r = f->dl->start(accept.isEmpty() ? QByteArray("application/json") : accept);
+
+	m_senders.insert(r, f);
+	f->reply = r;
+
+	QObject::connect(r, SIGNAL(readyRead()), this, SLOT(readChunk()));
+}
+
+void MirrorServer::forget(MirrorConnection *c) {
+	foreach(Fetch *f, m_fetches) f->waiting.removeAll(c);
+}
+
+void MirrorServer::updateReply(QNetworkReply *r) {
+
+	Fetch *f = m_senders.value(sender(), 0L);
+
+	if(!f) return;
+
+	if(f->reply) {
+		QObject::disconnect(f->reply, SIGNAL(readyRead()), this, SLOT(readChunk()));
+		m_senders.remove(f->reply);
+	}
+
+	// a retried or redirected request starts over
+	delete f->sink;
+	f->sink = 0L;
+	f->errorBody.clear();
+	f->broken = false;
+
+	m_senders.insert(r, f);
+	f->reply = r;
+
+	QObject::connect(r, SIGNAL(readyRead()), this, SLOT(readChunk()));
+}
+
+void MirrorServer::readChunk() {
+
+	Fetch *f = m_senders.value(sender(), 0L);
+
+	if(!f || f->reply != sender()) return;
+
+	const int status = f->reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	QByteArray data;
+
+	if(f->broken || !f->dl->decode(f->reply->readAll(), data)) {
+		f->broken = true;
+		return;
+	}
+
+	if(isSuccess(status)) {
+
+		if(!f->sink) {
+
+			f->sink = new FileSink(bodyFile(f->key));
+
+			if(!f->sink->open(QIODevice::WriteOnly)) f->broken = true;
+		}
+
+		if(!f->broken && f->sink->write(data) == Q_INT64_C(-1)) f->broken = true;
+
+	} else if(status >= 400) {
+		f->errorBody.append(data);
+	}
+}
+
+void MirrorServer::downloaded(const FileDownloader &dl) {
+
+	Fetch *f = m_senders.value(&dl, 0L);
+
+	if(!f) return;
+
+	const int status = dl.httpStatus();
+
+	if(status == 304 && f->old.isValid()) {
+
+		Entry e(f->old);
+
+		e.fetched = QDateTime::currentMSecsSinceEpoch();
+		store(f->key, e);
+
+		finish(f, "REVALIDATED");
+		return;
+	}
+
+	if(!isSuccess(status)) {
+		finish(f, 0L, status, f->errorBody + dl.downloadedData());
+		return;
+	}
+
+	if(!f->sink && !f->broken) {
+
+		f->sink = new FileSink(bodyFile(f->key));
+
+		if(!f->sink->open(QIODevice::WriteOnly)) f->broken = true;
+	}
+
+	// the rest got buffered by the downloader
+	if(!f->broken && !dl.downloadedData().isEmpty() &&
+			f->sink->write(dl.downloadedData()) == Q_INT64_C(-1)) {
+		f->broken = true;
+	}
+
+	// a cut off encoded body must not replace the cached one
+	if(!dl.decodeFinished()) {
+
+		if(f->old.isValid()) {
+			finish(f, "STALE");
+		} else {
+			finish(f, 0L, 502, jsonMessage(QString("Failed to decode %1").
+										   arg(dl.url().toString())));
+		}
+
+		return;
+	}
+
+	if(f->broken || !f->sink->commit()) {
+		finish(f, 0L, 502, jsonMessage(QString("cannot cache %1").arg(dl.url().toString())));
+		return;
+	}
+
+	Entry e;
+
+	e.status  = status;
+	e.fetched = QDateTime::currentMSecsSinceEpoch();
+
+	foreach(const FileDownloader::RAWHEADERPAIR &h, dl.rawHeaderPairs()) {
+
+		const QByteArray &name(h.first.toLower());
+
+		if(name == "content-type") {
+			e.contentType = h.second;
+		} else if(name == "etag") {
+			e.eTag = h.second;
+		} else if(name == "last-modified") {
+			e.lastModified = h.second;
+		}
+	}
+
+	store(f->key, e);
+	finish(f, "MISS");
+	evict();
+}
+
+void MirrorServer::failed(const QString &err) {
+
+	Fetch *f = m_senders.value(sender(), 0L);
+
+	if(!f) return;
+
+	const int status = f->reply ?
+				f->reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() : 0;
+
+	qWarning("%s: %s", qPrintable(f->dl->url().toString()), qPrintable(err));
+
+	// the clients have to know about missing releases, but not about an outage
+	if(status >= 400 && status <= 499 && status != 429) {
+		finish(f, 0L, status, f->errorBody.isEmpty() ? jsonMessage(err) : f->errorBody);
+	} else if(f->old.isValid()) {
+		finish(f, "STALE");
+	} else {
+		finish(f, 0L, 502, jsonMessage(err));
+	}
+}
+
+void MirrorServer::finish(Fetch *f, const char *state, int status, const QByteArray &body) {
+
+	m_fetches.remove(f->key);
+	m_senders.remove(f->dl);
+	m_senders.remove(f->reply);
+
+	const Entry &e(m_entries.value(f->key));
+
+	foreach(MirrorConnection *c, f->waiting) {
+		if(state) {
+			c->serve(f->key, e, state);
+		} else {
+			c->respond(status, "application/json; charset=utf-8", body);
+		}
+	}
+
+	delete f;
+}
+
+MirrorConnection::MirrorConnection(QTcpSocket *s, MirrorServer &srv) : QObject(s),
+	m_socket(s), m_server(srv), m_request(), m_ifNoneMatch(), m_body(),
+	m_requested(false), m_responded(false) {
+
+	QObject::connect(m_socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+	QObject::connect(m_socket, SIGNAL(disconnected()), m_socket, SLOT(deleteLater()));
+}
+
+MirrorConnection::~MirrorConnection() {
+	m_server.forget(this);
+}
+
+void MirrorConnection::readRequest() {
+
+	if(m_requested || m_responded) {
+		m_socket->readAll();
+		return;
+	}
+
+	m_request.append(m_socket->readAll());
+
+	if(!m_request.contains("\r\n\r\n")) {
+		if(m_request.size() > 65536) respond(400, "text/plain", "Request too large");
+		return;
+	}
+
+	const QList<QByteArray> &lines(m_request.left(m_request.indexOf("\r\n\r\n")).
+								   split('\n'));
+	const QList<QByteArray> &req(lines.first().trimmed().split(' '));
+
+	QByteArray accept;
+
+	foreach(const QByteArray &l, lines) {
+
+		const QByteArray &lc(l.toLower());
+
+		if(lc.startsWith("accept:")) accept = l.mid(7).trimmed();
+		if(lc.startsWith("if-none-match:")) m_ifNoneMatch = l.mid(14).trimmed();
+	}
+
+	if(req.count() < 2 || req[0] != "GET") {
+		respond(405, "application/json; charset=utf-8", jsonMessage("Method Not Allowed"));
+		return;
+	}
+
+	const QByteArray &target(req[1]);
+	const QByteArray &raw(target.left(target.indexOf('?')));
+	const QString &path(QString::fromUtf8(QByteArray::fromPercentEncoding(raw).constData()));
+
+	// percent-encoded dots and the like must not leave the API either
+	if(!isMirrored(path) || QDir::cleanPath(path) != path || path.contains('\\')) {
+		respond(404, "application/json; charset=utf-8", jsonMessage("Not Found"));
+		return;
+	}
+
+	// one request per connection, pipelined ones get ignored
+	m_requested = true;
+	m_server.request(this, target, accept);
+}
+
+void MirrorConnection::serve(const QByteArray &key, const MirrorServer::Entry &e,
+							 const char *state) {
+
+	QByteArray h;
+
+	h.append("Content-Type: ").append(e.contentType).append("\r\n");
+	if(!e.eTag.isEmpty()) h.append("ETag: ").append(e.eTag).append("\r\n");
+	if(!e.lastModified.isEmpty()) h.append("Last-Modified: ").append(e.lastModified).
+			append("\r\n");
+	h.append("X-Mirror-Cache: ").append(state).append("\r\n");
+
+	if(!m_ifNoneMatch.isEmpty() && m_ifNoneMatch == e.eTag) {
+		send(304, h, QByteArray());
+		return;
+	}
+
+	m_body.setFileName(m_server.bodyFile(key));
+
+	if(!m_body.open(QIODevice::ReadOnly)) {
+		respond(502, "application/json; charset=utf-8", jsonMessage(m_body.errorString()));
+		return;
+	}
+
+	if(e.contentType.contains("json")) {
+
+		// the clients shall follow the links through the mirror
+		const QByteArray &body(m_body.readAll().replace(stripSlash(m_server.config().upstream),
+														stripSlash(m_server.config().publicUrl)));
+
+		m_body.close();
+		send(e.status, h, body);
+		return;
+	}
+
+	h.append("Content-Length: ").append(QByteArray::number(m_body.size())).append("\r\n");
+
+	send(e.status, h, QByteArray());
+
+	QObject::connect(m_socket, SIGNAL(bytesWritten(qint64)), this, SLOT(sendChunk()));
+	sendChunk();
+}
+
+void MirrorConnection::respond(int status, const QByteArray &contentType,
+							   const QByteArray &body) {
+	send(status, QByteArray("Content-Type: ").append(contentType).append("\r\n"), body);
+}
+
+void MirrorConnection::send(int status, const QByteArray &headers, const QByteArray &body) {
+
+	if(m_responded) return;
+
+	m_responded = true;
+
+	QByteArray r("HTTP/1.1 ");
+
+	r.append(QByteArray::number(status)).append(' ').append(reason(status)).append("\r\n");
+	r.append(headers);
+
+	// streamed bodies announced their length already
+	if(!m_body.isOpen()) {
+		r.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+	}
+
+	r.append("Connection: close\r\n\r\n").append(body);
+
+	m_socket->write(r);
+
+	if(!m_body.isOpen()) m_socket->disconnectFromHost();
+}
+
+void MirrorConnection::sendChunk() {
+
+	// keep the socket busy without reading the whole file into memory
+	while(m_body.isOpen() && m_socket->bytesToWrite() < 4 * CHUNK) {
+
+		const QByteArray &data(m_body.read(CHUNK));
+
+		if(data.isEmpty()) {
+			m_body.close();
+			m_socket->disconnectFromHost();
+			break;
+		}
+
+		m_socket->write(data);
+	}
+}
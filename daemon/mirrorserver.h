@@ -0,0 +1,158 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIRRORSERVER_H
+#define MIRRORSERVER_H
+
+#include <QHash>
+#include <QFile>
+#include <QTcpServer>
+
+#include "filedownloader.h"
+
+QT_FORWARD_DECLARE_CLASS(QTcpSocket)
+
+class FileSink;
+class MirrorConnection;
+
+/**
+ * Caching mirror of the GitHub release API
+ *
+ * Serves the release lists, the latest release, releases by tag, assets,
+ * tarballs, zipballs and the emoji table from a cache directory, and nothing
+ * else of the API. Entries older than @c maxAge get revalidated upstream with
+ * a conditional request, which doesn't count against the rate limit if
+ * nothing changed. Clients asking for the same entry meanwhile wait for a
+ * single upstream request.
+ *
+ * If upstream fails, the stale entry is served if there is one. The API URLs
+ * contained in JSON responses are rewritten to point to @c publicUrl, thus the
+ * clients fetch assets and archives through the mirror as well.
+ *
+ * The entries fetched least recently are evicted as soon as the cache
+ * exceeds @c maxCacheSize bytes.
+ */
+class MirrorServer : public QTcpServer {
+	Q_OBJECT
+	Q_DISABLE_COPY(MirrorServer)
+public:
+	struct Config {
+		Config();
+
+		QUrl upstream;
+		QString cacheDir;
+		int maxAge; ///< seconds an entry is served without revalidation
+		qint64 maxCacheSize; ///< bytes of cached bodies, @c 0 for no limit
+		QByteArray token;
+		QUrl publicUrl; ///< the URL clients reach the mirror at
+	};
+
+	/// the cached response to a request
+	struct Entry {
+		Entry();
+
+		inline bool isValid() const {
+			return status != 0;
+		}
+
+		int status;
+		QByteArray contentType;
+		QByteArray eTag;
+		QByteArray lastModified;
+		qint64 fetched;
+	};
+
+	explicit MirrorServer(const Config &cnf, QObject *parent = 0);
+	virtual ~MirrorServer();
+
+	inline const Config &config() const {
+		return m_cnf;
+	}
+
+	/// answers @c c from the cache or from upstream, later
+	void request(MirrorConnection *c, const QByteArray &target, const QByteArray &accept);
+
+	/// stops answering @c c, it went away
+	void forget(MirrorConnection *c);
+
+	QString bodyFile(const QByteArray &key) const;
+
+protected:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+	virtual void incomingConnection(qintptr socketDescriptor);
+#else
+	virtual void incomingConnection(int socketDescriptor);
+#endif
+
+private slots:
+	void updateReply(QNetworkReply *);
+	void readChunk();
+	void downloaded(const FileDownloader &);
+	void failed(const QString &);
+
+private:
+	struct Fetch;
+
+	Entry entry(const QByteArray &key);
+	bool store(const QByteArray &key, const Entry &e);
+	void evict();
+	void finish(Fetch *f, const char *state, int status = 0,
+				const QByteArray &body = QByteArray());
+
+private:
+	const Config m_cnf;
+	QHash<QByteArray, Entry> m_entries;
+	QHash<QByteArray, Fetch *> m_fetches;
+	QHash<const QObject *, Fetch *> m_senders; ///< the fetch of a downloader or of its reply
+};
+
+/**
+ * A single HTTP exchange on a mirror connection
+ */
+class MirrorConnection : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(MirrorConnection)
+public:
+	MirrorConnection(QTcpSocket *socket, MirrorServer &server);
+	virtual ~MirrorConnection();
+
+	/// sends the cached entry, @c state goes to the @em X-Mirror-Cache header
+	void serve(const QByteArray &key, const MirrorServer::Entry &e, const char *state);
+
+	/// sends a response not taken from the cache
+	void respond(int status, const QByteArray &contentType, const QByteArray &body);
+
+private slots:
+	void readRequest();
+	void sendChunk();
+
+private:
+	void send(int status, const QByteArray &headers, const QByteArray &body);
+
+private:
+	QTcpSocket *const m_socket;
+	MirrorServer &m_server;
+	QByteArray m_request;
+	QByteArray m_ifNoneMatch;
+	QFile m_body;
+	bool m_requested;
+	bool m_responded;
+};
+
+#endif // MIRRORSERVER_H
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QThread>
+#include <QMutex>
+#include <QElapsedTimer>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QJsonDocument>
+#elif defined(QJSON_FOUND)
+#include <qjson/parser.h>
+#endif
+
+#include "apiworker.h"
+#include "jsonindex.h"
+#include "jsonparser.h"
+
+namespace {
+
+class WorkerThread : public QThread {
+public:
+	virtual ~WorkerThread() {
+		quit();
+		wait();
+	}
+};
+
+QMutex workerThreadMutex;
+
+}
+
+Q_GLOBAL_STATIC(WorkerThread, globalWorkerThread)
+
+bool ApiWorker::m_lazyParsing = false;
+ApiWorker::PARSER ApiWorker::m_parser = ApiWorker::AUTO;
+
+ApiWorker::ApiWorker(const QUrl &url, const char *userAgent, const QString &eTag) : QObject(),
+	m_url(url), m_downloader(new FileDownloader(url, userAgent, eTag, this)) {
+
+	qRegisterMetaType<FileDownloader::RAWHEADERPAIRLIST>("FileDownloader::RAWHEADERPAIRLIST");
+	qRegisterMetaType<QSharedPointer<JsonIndex> >("QSharedPointer<JsonIndex>");
+
+	m_downloader->setBuffered(true);
+	m_downloader->setPriority(FileDownloader::HIGH);
+
+	QObject::connect(m_downloader, SIGNAL(error(QString)), this, SIGNAL(error(QString)));
+	QObject::connect(m_downloader, SIGNAL(progress(qint64,qint64)),
+					 this, SIGNAL(progress(qint64,qint64)));
+	QObject::connect(m_downloader, SIGNAL(downloaded(FileDownloader)),
+					 this, SLOT(downloaded(FileDownloader)));
+}
+
+ApiWorker::~ApiWorker() {}
+
+QThread *ApiWorker::workerThread() {
+
+	QMutexLocker lock(&workerThreadMutex);
+
+	QThread *t = globalWorkerThread();
+
+	if(t && !t->isRunning()) t->start();
+
+	return t;
+}
+
+void ApiWorker::start(int type, const QString &eTag) {
+	m_downloader->setETag(eTag);
+	m_downloader->start(static_cast<QGitHubReleaseAPI::TYPE>(type));
+}
+
+void ApiWorker::cancel() {
+	m_downloader->abort();
+}
+
+void ApiWorker::downloaded(const FileDownloader &fd) {
+
+	QString err;
+	QVariant data;
+	const QByteArray &json(fd.downloadedData());
+
+	// a 304 has no body, the caller keeps its data
+	if(fd.httpStatus() != 304) {
+
+		QElapsedTimer timer;
+		timer.start();
+
+		if(m_lazyParsing) {
+
+			const QSharedPointer<JsonIndex> idx(new JsonIndex(json));
+
+			// let the parser tell what's wrong
+			data = idx->isValid() ? QVariant::fromValue(idx) : parseJSon(json, err);
+
+		} else {
+			data = parseJSon(json, err);
+		}
+
+		QGitHubReleaseInstrumentation::instance()->
+				recordPhase(QGitHubReleaseInstrumentation::PARSE, timer.nsecsElapsed());
+	}
+
+	emit finished(json, data, err, fd.httpStatus(), fd.rawHeaderPairs());
+}
+
+QVariant ApiWorker::parseJSon(const QByteArray &ba, QString &err) {
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) || defined(QJSON_FOUND)
+	if(m_parser == BUILTIN) {
+#endif
+		JsonParser parser(ba);
+		return parser.parse(err);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) || defined(QJSON_FOUND)
+	}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+	QJson::Parser parser;
+	bool ok = false;
+#else
+	QJsonParseError ok;
+#endif
+
+	err = QString::null;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+
+	QVariant v(QJsonDocument::fromJson(ba, &ok).toVariant());
+
+	if(ok.error == QJsonParseError::NoError) {
+		return v;
+	} else {
+		err = ok.errorString();
+	}
+
+#else
+
+	QVariant v(parser.parse(ba, &ok));
+
+	if(ok) {
+		return v;
+	} else {
+		err = parser.errorString();
+	}
+
+#endif
+
+	return QVariant();
+#endif
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef APIWORKER_H
+#define APIWORKER_H
+
+#include "filedownloader.h"
+
+QT_FORWARD_DECLARE_CLASS(QThread)
+
+/**
+ * Retrieves and parses the release information
+ *
+ * If moved to @c workerThread() networking and parsing are done there and
+ * the results are delivered by queued signals.
+ */
+class Q_DECL_HIDDEN ApiWorker : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(ApiWorker)
+public:
+	ApiWorker(const QUrl &url, const char *userAgent, const QString &eTag = QString::null);
+	virtual ~ApiWorker();
+
+	static QThread *workerThread();
+
+	typedef enum { AUTO, ///< NATIVE, or BUILTIN if the build provides no native parser
+				   NATIVE, ///< @c QJsonDocument or QJson, whatever the build provides
+				   BUILTIN ///< the built-in parser with the selected JsonParser::ISA (opt-in)
+				 } PARSER;
+
+	static QVariant parseJSon(const QByteArray &ba, QString &err);
+
+	inline static void setParser(PARSER p) {
+		m_parser = p;
+	}
+
+	inline static void setLazyParsing(bool b) {
+		m_lazyParsing = b;
+	}
+
+	inline QUrl url() const {
+		return m_url;
+	}
+
+public slots:
+	void start(int type, const QString &eTag);
+	void cancel();
+
+signals:
+	void finished(const QByteArray &json, const QVariant &data, const QString &err,
+				  int httpStatus, const FileDownloader::RAWHEADERPAIRLIST &headers);
+	void error(const QString &);
+	void progress(qint64, qint64);
+
+private slots:
+	void downloaded(const FileDownloader &);
+
+private:
+	static bool m_lazyParsing;
+	static PARSER m_parser;
+
+	const QUrl m_url;
+	FileDownloader *const m_downloader;
+};
+
+#endif // APIWORKER_H
@@ -0,0 +1,691 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+#include <QFileInfo>
+#include <QStringList>
+
+#include "archiveextractor.h"
+#include "contentdecoder.h"
+
+namespace {
+
+const int BLOCKSIZE = 512;
+const int CHUNKSIZE = 16384;
+const int MAXMETA = 1048576;
+
+const quint32 ZIP_LOCAL = 0x04034b50;
+const quint32 ZIP_CENTRAL = 0x02014b50;
+const quint32 ZIP_END = 0x06054b50;
+const quint32 ZIP_DESCRIPTOR = 0x08074b50;
+
+inline quint16 le16(const uchar *p) {
+	return static_cast<quint16>(p[0] | (p[1] << 8));
+}
+
+inline quint32 le32(const uchar *p) {
+	return le16(p) | (static_cast<quint32>(le16(p + 2)) << 16);
+}
+
+inline quint64 le64(const uchar *p) {
+	return le32(p) | (static_cast<quint64>(le32(p + 4)) << 32);
+}
+
+qint64 octal(const char *f, int len) {
+
+	qint64 v = Q_INT64_C(0);
+
+	// GNU base-256 encoding of large values
+	if(static_cast<uchar>(*f) & 0x80) {
+
+		v = static_cast<uchar>(*f) & 0x7F;
+
+		for(int i = 1; i < len; ++i) v = (v << 8) | static_cast<uchar>(f[i]);
+
+		return v;
+	}
+
+	int i = 0;
+
+	while(i < len && f[i] == ' ') ++i;
+
+	for(; i < len && f[i] >= '0' && f[i] <= '7'; ++i) v = (v << 3) | (f[i] - '0');
+
+	return v;
+}
+
+QString field(const char *f, int len) {
+	return QString::fromUtf8(f, static_cast<int>(qstrnlen(f, static_cast<uint>(len))));
+}
+
+bool checksum(const char *h) {
+
+	qint64 sum = Q_INT64_C(0);
+
+	for(int i = 0; i < BLOCKSIZE; ++i) {
+		sum += (i >= 148 && i < 156) ? ' ' : static_cast<uchar>(h[i]);
+	}
+
+	return sum == octal(h + 148, 8);
+}
+
+QString paxPath(const QByteArray &pax) {
+
+	QString path;
+
+	// records are "<length> <key>=<value>\n"
+	for(int i = 0; i < pax.size();) {
+
+		const int sp = pax.indexOf(' ', i);
+		const int len = sp != -1 ? pax.mid(i, sp - i).toInt() : 0;
+
+		if(len <= sp - i + 1 || i + len > pax.size()) break;
+
+		const QByteArray &rec(pax.mid(sp + 1, len - (sp - i) - 2));
+
+		if(rec.startsWith("path=")) path = QString::fromUtf8(rec.constData() + 5, rec.size() - 5);
+
+		i += len;
+	}
+
+	return path;
+}
+
+}
+
+ArchiveExtractor::ArchiveExtractor(FORMAT format, const QString &directory,
+								   const QStringList &filters) : QIODevice(), m_format(format),
+	m_dir(directory), m_filters(), m_decoder(0L), m_zs(0L), m_buf(), m_pos(0), m_state(HEADER),
+	m_left(Q_INT64_C(0)), m_skip(Q_INT64_C(0)), m_pad(Q_INT64_C(0)), m_meta(), m_longName(),
+	m_file(), m_mode(0u), m_crc(0u), m_expectedCrc(0u), m_deflated(false), m_descriptor(false),
+	m_zip64(false), m_failed(false), m_files(0) {
+
+	m_dir.makeAbsolute();
+
+	foreach(const QString &f, filters) {
+		m_filters.append(QRegExp(f, Qt::CaseSensitive, QRegExp::Wildcard));
+	}
+}
+
+ArchiveExtractor::~ArchiveExtractor() {
+	close();
+}
+
+bool ArchiveExtractor::open(OpenMode mode) {
+
+	if((mode & ReadOnly) || !(mode & WriteOnly)) {
+		setErrorString("archives can only be written");
+		return false;
+	}
+
+	if(!m_dir.mkpath(".")) {
+		setErrorString(QString("cannot create %1").arg(m_dir.path()));
+		return false;
+	}
+
+	restart();
+
+	if(m_format == TARGZ && !m_decoder) {
+		setErrorString("gzip compressed archives are not supported");
+		return false;
+	}
+
+	return QIODevice::open(mode);
+}
+
+void ArchiveExtractor::close() {
+
+	// whatever is still open got cut off
+	if(m_file.isOpen()) {
+		m_file.close();
+		m_file.remove();
+	}
+
+	delete m_decoder;
+	m_decoder = 0L;
+
+#ifdef HAVE_ZLIB_H
+	if(m_zs) {
+		inflateEnd(m_zs);
+		delete m_zs;
+		m_zs = 0L;
+	}
+#endif
+
+	QIODevice::close();
+}
+
+bool ArchiveExtractor::isSequential() const {
+	return true;
+}
+
+bool ArchiveExtractor::restart() {
+
+	if(m_file.isOpen()) {
+		m_file.close();
+		m_file.remove();
+	}
+
+	delete m_decoder;
+	m_decoder = m_format == TARGZ ? ContentDecoder::create("gzip") : 0L;
+
+	m_buf.clear();
+	m_pos = 0;
+	m_state = HEADER;
+	m_left = m_skip = m_pad = Q_INT64_C(0);
+	m_meta.clear();
+	m_longName.clear();
+	m_failed = false;
+	m_files = 0;
+
+	return true;
+}
+
+bool ArchiveExtractor::finish() {
+
+	if(m_failed) return false;
+
+	if(m_format == TARGZ && !m_decoder->isFinished()) return fail("truncated gzip data");
+
+	// tar archives lacking the end marker are fine as long as no entry got cut off
+	if(m_state == END || (m_format == TARGZ && m_state == HEADER && !available() && !m_skip)) {
+		return true;
+	}
+
+	return fail("truncated archive");
+}
+
+qint64 ArchiveExtractor::readData(char *, qint64) {
+	return Q_INT64_C(-1);
+}
+
+qint64 ArchiveExtractor::writeData(const char *data, qint64 len) {
+
+	if(m_failed) return Q_INT64_C(-1);
+
+	const QByteArray in(QByteArray::fromRawData(data, static_cast<int>(len)));
+	bool ok;
+
+	if(m_format == TARGZ) {
+		ok = m_decoder->decode(in, m_buf) ? tar() : fail("invalid gzip data");
+	} else {
+		m_buf.append(in);
+		ok = zip();
+	}
+
+	m_buf.remove(0, m_pos);
+	m_pos = 0;
+
+	return ok ? len : Q_INT64_C(-1);
+}
+
+bool ArchiveExtractor::tar() {
+
+	for(;;) {
+
+		if(m_skip) {
+
+			const qint64 n = qMin(m_skip, static_cast<qint64>(available()));
+
+			m_pos += static_cast<int>(n);
+
+			if((m_skip -= n)) return true;
+		}
+
+		const char *p = m_buf.constData() + m_pos;
+		const int n = static_cast<int>(qMin(m_left, static_cast<qint64>(available())));
+
+		switch(m_state) {
+		case HEADER:
+
+			if(available() < BLOCKSIZE) return true;
+
+			m_pos += BLOCKSIZE;
+
+			if(!tarHeader(p)) return false;
+
+			break;
+		case LONGNAME:
+		case PAX:
+
+			m_meta.append(p, n);
+			m_pos += n;
+
+			if((m_left -= n)) return true;
+
+			m_longName = m_state == LONGNAME ? field(m_meta.constData(), m_meta.size()) :
+											   paxPath(m_meta);
+			m_skip = m_pad;
+			m_state = HEADER;
+			break;
+		case DATA:
+
+			if(!put(p, n)) return false;
+
+			m_pos += n;
+
+			if((m_left -= n)) return true;
+
+			if(!end(m_crc)) return false;
+
+			m_skip = m_pad;
+			m_state = HEADER;
+			break;
+		default:
+			m_pos = m_buf.size();
+			return true;
+		}
+	}
+}
+
+bool ArchiveExtractor::tarHeader(const char *h) {
+
+	// two zero blocks mark the end, the first one suffices
+	if(!*h && QByteArray::fromRawData(h, BLOCKSIZE).count('\0') == BLOCKSIZE) {
+		m_state = END;
+		return true;
+	}
+
+	if(!checksum(h)) return fail("invalid tar header");
+
+	const qint64 size = octal(h + 124, 12);
+
+	if(size < Q_INT64_C(0)) return fail("invalid tar header");
+
+	m_left = size;
+	m_pad = (BLOCKSIZE - size % BLOCKSIZE) % BLOCKSIZE;
+
+	switch(h[156]) {
+	case 'L':
+	case 'x':
+
+		if(size > MAXMETA) return fail("invalid tar header");
+
+		m_meta.clear();
+		m_state = h[156] == 'L' ? LONGNAME : PAX;
+		return true;
+	case '0':
+	case '\0':
+	case '5':
+	case '7': {
+
+		QString name(m_longName);
+
+		m_longName.clear();
+
+		if(name.isEmpty()) {
+
+			name = field(h, 100);
+
+			if(!qstrncmp(h + 257, "ustar", 5) && h[345]) {
+				name = field(h + 345, 155) + '/' + name;
+			}
+		}
+
+		const uint mode = static_cast<uint>(octal(h + 100, 8));
+
+		if(h[156] == '5') {
+			m_skip = size + m_pad;
+			return begin(name, true, mode);
+		}
+
+		m_state = DATA;
+		return begin(name, false, mode);
+	}
+	default: // global headers, links and special files
+
+		m_longName.clear();
+		m_skip = size + m_pad;
+		return true;
+	}
+}
+
+bool ArchiveExtractor::zip() {
+
+	for(;;) {
+
+		if(m_skip) {
+
+			const qint64 n = qMin(m_skip, static_cast<qint64>(available()));
+
+			m_pos += static_cast<int>(n);
+
+			if((m_skip -= n)) return true;
+		}
+
+		const uchar *p = reinterpret_cast<const uchar *>(m_buf.constData()) + m_pos;
+
+		switch(m_state) {
+		case HEADER: {
+
+			if(available() < 4) return true;
+
+			const quint32 sig = le32(p);
+
+			// the central directory follows the last entry
+			if(sig == ZIP_CENTRAL || sig == ZIP_END) {
+				m_state = END;
+				break;
+			}
+
+			if(sig != ZIP_LOCAL) return fail("invalid zip archive");
+
+			if(available() < 30 || available() < 30 + le16(p + 26) + le16(p + 28)) return true;
+
+			if(!zipHeader(p)) return false;
+
+			break;
+		}
+		case DATA: {
+
+			if(m_deflated) {
+
+				if(!inflateEntry()) return false;
+
+				if(m_state == DATA) return true;
+
+				break;
+			}
+
+			const int n = static_cast<int>(qMin(m_left, static_cast<qint64>(available())));
+
+			if(!put(reinterpret_cast<const char *>(p), n)) return false;
+
+			m_pos += n;
+
+			if((m_left -= n)) return true;
+
+			if(!end(m_expectedCrc)) return false;
+
+			m_state = HEADER;
+			break;
+		}
+		case DESCRIPTOR: {
+
+			if(available() < 4) return true;
+
+			const int sig = le32(p) == ZIP_DESCRIPTOR ? 4 : 0;
+			const int len = sig + (m_zip64 ? 20 : 12);
+
+			if(available() < len) return true;
+
+			m_pos += len;
+
+			if(!end(le32(p + sig))) return false;
+
+			m_state = HEADER;
+			break;
+		}
+		default:
+			m_pos = m_buf.size();
+			return true;
+		}
+	}
+}
+
+bool ArchiveExtractor::zipHeader(const uchar *h) {
+
+	const quint16 flags = le16(h + 6);
+	const quint16 method = le16(h + 8);
+	const int nlen = le16(h + 26);
+	const int xlen = le16(h + 28);
+	const char *name = reinterpret_cast<const char *>(h) + 30;
+	const uchar *x = h + 30 + nlen;
+	const uchar *const xend = x + xlen;
+
+	m_left = le32(h + 18);
+	m_expectedCrc = le32(h + 14);
+	m_zip64 = false;
+
+	for(; xend - x >= 4 && xend - x >= 4 + le16(x + 2); x += 4 + le16(x + 2)) {
+
+		if(le16(x) == 0x0001) {
+
+			m_zip64 = true;
+
+			// the compressed size follows the uncompressed one
+			if(le16(x + 2) >= 16 && m_left == Q_INT64_C(0xFFFFFFFF)) {
+				m_left = static_cast<qint64>(le64(x + 12));
+			}
+		}
+	}
+
+	m_pos += 30 + nlen + xlen;
+
+	const QString &path(flags & 0x0800 ? QString::fromUtf8(name, nlen) :
+										 QString::fromLatin1(name, nlen));
+
+	if(flags & 0x0001) return fail(QString("%1 is encrypted").arg(path));
+
+	m_descriptor = (flags & 0x0008) != 0;
+	m_deflated = method == 8;
+
+	if((method != 0 && !m_deflated) || (!m_deflated && m_descriptor)) {
+		return fail(QString("unsupported compression of %1").arg(path));
+	}
+
+	if(m_deflated) {
+#ifdef HAVE_ZLIB_H
+		if(!m_zs) {
+
+			m_zs = new z_stream;
+			m_zs->zalloc = Z_NULL;
+			m_zs->zfree  = Z_NULL;
+			m_zs->opaque = Z_NULL;
+			m_zs->next_in  = Z_NULL;
+			m_zs->avail_in = 0;
+
+			// zip entries are raw deflate streams
+			if(inflateInit2(m_zs, -MAX_WBITS) != Z_OK) {
+				delete m_zs;
+				m_zs = 0L;
+				return fail("cannot initialize zlib");
+			}
+
+		} else {
+			inflateReset(m_zs);
+		}
+#else
+		return fail(QString("unsupported compression of %1").arg(path));
+#endif
+	}
+
+	m_state = DATA;
+
+	return begin(path, path.endsWith('/'), 0u);
+}
+
+bool ArchiveExtractor::inflateEntry() {
+#ifdef HAVE_ZLIB_H
+	char out[CHUNKSIZE];
+	const qint64 avail = available();
+	const int feed = static_cast<int>(m_descriptor ? avail : qMin(m_left, avail));
+	int r;
+
+	m_zs->next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(m_buf.constData() + m_pos));
+	m_zs->avail_in = static_cast<uInt>(feed);
+
+	do {
+
+		m_zs->next_out  = reinterpret_cast<Bytef *>(out);
+		m_zs->avail_out = CHUNKSIZE;
+
+		r = inflate(m_zs, Z_NO_FLUSH);
+
+		if(r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR) return fail("invalid zip data");
+
+		if(!put(out, CHUNKSIZE - static_cast<int>(m_zs->avail_out))) return false;
+
+	} while(r == Z_OK && (m_zs->avail_in || !m_zs->avail_out));
+
+	const int used = feed - static_cast<int>(m_zs->avail_in);
+
+	m_pos += used;
+
+	if(!m_descriptor) m_left -= used;
+
+	if(r != Z_STREAM_END) {
+		return m_descriptor || m_left ? true : fail("invalid zip data");
+	}
+
+	if(m_descriptor) {
+		m_state = DESCRIPTOR;
+		return true;
+	}
+
+	m_skip = m_left;
+	m_left = Q_INT64_C(0);
+	m_state = HEADER;
+
+	return end(m_expectedCrc);
+#else
+	return fail("unsupported compression");
+#endif
+}
+
+bool ArchiveExtractor::begin(const QString &name, bool dir, uint mode) {
+
+	QString rel(QDir::cleanPath(QString(name).replace('\\', '/')));
+
+	if(QDir::isAbsolutePath(rel) || rel == ".." || rel.startsWith("../")) {
+		return fail(QString("refusing to extract %1").arg(name));
+	}
+
+#ifdef Q_OS_WIN
+	if(rel.contains(':')) return fail(QString("refusing to extract %1").arg(name));
+#endif
+
+	const int slash = rel.indexOf('/');
+
+	// the leading directory itself
+	if(slash == -1) return true;
+
+	rel = rel.mid(slash + 1);
+
+	if(throughLink(rel, dir)) return fail(QString("refusing to extract %1 through a link").
+										  arg(name));
+
+	if(dir) {
+		return !m_filters.isEmpty() || m_dir.mkpath(rel) ||
+				fail(QString("cannot create %1").arg(m_dir.absoluteFilePath(rel)));
+	}
+
+	bool wanted = m_filters.isEmpty();
+
+	for(QList<QRegExp>::const_iterator i(m_filters.constBegin());
+			!wanted && i != m_filters.constEnd(); ++i) {
+		wanted = i->exactMatch(rel);
+	}
+
+	if(!wanted) return true;
+
+	const QString &path(m_dir.absoluteFilePath(rel));
+
+	if(!m_dir.mkpath(QFileInfo(rel).path())) {
+		return fail(QString("cannot create %1").arg(QFileInfo(path).path()));
+	}
+
+	// never write through a link placed there before
+	if(QFileInfo(path).isSymLink() && !QFile::remove(path)) {
+		return fail(QString("cannot remove the link %1").arg(path));
+	}
+
+	m_file.setFileName(path);
+
+	if(!m_file.open(QFile::WriteOnly|QFile::Truncate)) return fail(m_file.errorString());
+
+	m_mode = mode;
+	m_crc = 0u;
+
+	return true;
+}
+
+bool ArchiveExtractor::throughLink(const QString &rel, bool dir) const {
+
+	const QStringList &parts(rel.split('/', QString::SkipEmptyParts));
+
+	// a file may replace a link, but nothing may be created below one
+	for(int i = 1; i <= parts.count() - (dir ? 0 : 1); ++i) {
+		if(QFileInfo(m_dir.absoluteFilePath(QStringList(parts.mid(0, i)).join("/"))).
+				isSymLink()) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ArchiveExtractor::put(const char *data, qint64 len) {
+
+	if(!m_file.isOpen() || !len) return true;
+
+#ifdef HAVE_ZLIB_H
+	if(m_format == ZIP) {
+		m_crc = static_cast<quint32>(crc32(m_crc, reinterpret_cast<const Bytef *>(data),
+										   static_cast<uInt>(len)));
+	}
+#endif
+
+	return m_file.write(data, len) == len || fail(m_file.errorString());
+}
+
+bool ArchiveExtractor::end(quint32 crc) {
+
+	if(!m_file.isOpen()) return true;
+
+	if(!m_file.flush()) return fail(m_file.errorString());
+
+#ifdef HAVE_ZLIB_H
+	if(m_format == ZIP && crc != m_crc) {
+		return fail(QString("checksum mismatch of %1").arg(m_file.fileName()));
+	}
+#else
+	Q_UNUSED(crc)
+#endif
+
+	m_file.close();
+
+	QFile::Permissions p(m_file.permissions());
+
+	if(m_mode & 0100) p |= QFile::ExeOwner|QFile::ExeUser;
+	if(m_mode & 0010) p |= QFile::ExeGroup;
+	if(m_mode & 0001) p |= QFile::ExeOther;
+
+	if(p != m_file.permissions()) m_file.setPermissions(p);
+
+	++m_files;
+
+	return true;
+}
+
+bool ArchiveExtractor::fail(const QString &err) {
+
+	if(m_file.isOpen()) {
+		m_file.close();
+		m_file.remove();
+	}
+
+	setErrorString(err);
+	m_failed = true;
+
+	return false;
+}
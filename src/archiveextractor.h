@@ -0,0 +1,113 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARCHIVEEXTRACTOR_H
+#define ARCHIVEEXTRACTOR_H
+
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+
+class ContentDecoder;
+struct z_stream_s;
+
+/**
+ * Unpacks a tarball (gzip compressed tar) or a zipball written to it
+ *
+ * Meant as output device of a download, the archive is unpacked chunk by
+ * chunk as it arrives and never stored as a whole. The leading directory
+ * GitHub puts all files into is stripped.
+ *
+ * Entries leaving the target directory abort the extraction, links and
+ * special files are skipped, as well as paths through links existing in the
+ * target directory. @c restart starts over, i.e. for a retried download.
+ */
+class Q_DECL_HIDDEN ArchiveExtractor : public QIODevice {
+	Q_OBJECT
+	Q_DISABLE_COPY(ArchiveExtractor)
+public:
+	typedef enum { TARGZ, ZIP } FORMAT;
+
+	ArchiveExtractor(FORMAT format, const QString &directory, const QStringList &filters);
+	virtual ~ArchiveExtractor();
+
+	virtual bool open(OpenMode mode);
+	virtual void close();
+	virtual bool isSequential() const;
+
+	bool restart();
+	bool finish();
+
+	inline bool hasFailed() const {
+		return m_failed;
+	}
+
+	inline int extractedFiles() const {
+		return m_files;
+	}
+
+protected:
+	virtual qint64 readData(char *data, qint64 maxSize);
+	virtual qint64 writeData(const char *data, qint64 len);
+
+private:
+	typedef enum { HEADER, LONGNAME, PAX, DATA, DESCRIPTOR, END } STATE;
+
+	bool tar();
+	bool tarHeader(const char *h);
+	bool zip();
+	bool zipHeader(const uchar *h);
+	bool inflateEntry();
+
+	bool begin(const QString &name, bool dir, uint mode);
+	bool throughLink(const QString &rel, bool dir) const;
+	bool put(const char *data, qint64 len);
+	bool end(quint32 crc);
+	bool fail(const QString &err);
+
+	inline int available() const {
+		return m_buf.size() - m_pos;
+	}
+
+private:
+	const FORMAT m_format;
+	QDir m_dir;
+	QList<QRegExp> m_filters;
+	ContentDecoder *m_decoder;
+	z_stream_s *m_zs;
+	QByteArray m_buf;
+	int m_pos;
+	STATE m_state;
+	qint64 m_left;
+	qint64 m_skip;
+	qint64 m_pad;
+	QByteArray m_meta;
+	QString m_longName;
+	QFile m_file;
+	uint m_mode;
+	quint32 m_crc;
+	quint32 m_expectedCrc;
+	bool m_deflated;
+	bool m_descriptor;
+	bool m_zip64;
+	bool m_failed;
+	int m_files;
+};
+
+#endif // ARCHIVEEXTRACTOR_H
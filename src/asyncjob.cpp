@@ -0,0 +1,53 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "asyncjob.h"
+#include "resourcecache.h"
+#include "filedownloader.h"
+
+void JobNotifier::notifyBody(int idx, const QString &body, const QString &err) {
+	emit bodyRendered(idx, body, err);
+	deleteLater();
+}
+
+void JobNotifier::notifyAvatar(int idx, const QImage &avatar) {
+	emit avatarDecoded(idx, avatar);
+	deleteLater();
+}
+
+BodyJob::BodyJob(JobNotifier *notifier, int idx, const QString &body,
+				 QGitHubReleaseAPI::TYPE type, const QSharedPointer<ResourceCache> &resources) :
+	QRunnable(), m_notifier(notifier), m_idx(idx), m_body(body), m_resources(resources),
+	m_renderer(type, *resources) {}
+
+void BodyJob::run() {
+
+	QString err;
+	const QString &b(m_renderer.render(m_body, err));
+
+	m_notifier->notifyBody(m_idx, b, err);
+}
+
+AvatarJob::AvatarJob(JobNotifier *notifier, int idx, const QUrl &url, const char *userAgent) :
+	QRunnable(), m_notifier(notifier), m_idx(idx), m_url(url), m_userAgent(userAgent) {}
+
+void AvatarJob::run() {
+	m_notifier->notifyAvatar(m_idx, QImage::fromData(FileDownloader::fetch(m_url, m_userAgent,
+																			FileDownloader::HIGH)));
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASYNCJOB_H
+#define ASYNCJOB_H
+
+#include <QRunnable>
+#include <QSharedPointer>
+
+#include "bodyrenderer.h"
+
+/**
+ * Delivers the result of an asynchronous job
+ *
+ * Lives in the thread the job got started from, thus its signals reach the
+ * receivers there by queued connections. It deletes itself after delivery.
+ */
+class Q_DECL_HIDDEN JobNotifier : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(JobNotifier)
+public:
+	JobNotifier() : QObject() {}
+
+	void notifyBody(int idx, const QString &body, const QString &err);
+	void notifyAvatar(int idx, const QImage &avatar);
+
+signals:
+	void bodyRendered(int idx, const QString &body, const QString &err);
+	void avatarDecoded(int idx, const QImage &avatar);
+};
+
+/**
+ * Renders a body on the global @c QThreadPool
+ */
+class Q_DECL_HIDDEN BodyJob : public QRunnable {
+	Q_DISABLE_COPY(BodyJob)
+public:
+	BodyJob(JobNotifier *notifier, int idx, const QString &body, QGitHubReleaseAPI::TYPE type,
+			const QSharedPointer<ResourceCache> &resources);
+
+	virtual void run();
+
+private:
+	JobNotifier *const m_notifier;
+	const int m_idx;
+	const QString m_body;
+	const QSharedPointer<ResourceCache> m_resources;
+	const BodyRenderer m_renderer;
+};
+
+/**
+ * Downloads and decodes an avatar on the global @c QThreadPool
+ */
+class Q_DECL_HIDDEN AvatarJob : public QRunnable {
+	Q_DISABLE_COPY(AvatarJob)
+public:
+	AvatarJob(JobNotifier *notifier, int idx, const QUrl &url, const char *userAgent);
+
+	virtual void run();
+
+private:
+	JobNotifier *const m_notifier;
+	const int m_idx;
+	const QUrl m_url;
+	const char *m_userAgent;
+};
+
+#endif // ASYNCJOB_H
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits>
+
+#include "bandwidthlimiter.h"
+
+Q_GLOBAL_STATIC(BandwidthLimiter, globalLimiter)
+
+qint64 BandwidthLimiter::m_transferRate = Q_INT64_C(0);
+
+BandwidthLimiter::BandwidthLimiter(qint64 rate) : m_mutex(), m_clock(),
+	m_credited(Q_INT64_C(0)), m_tokens(rate), m_rate(rate) {
+	m_clock.start();
+}
+
+BandwidthLimiter *BandwidthLimiter::global() {
+	return globalLimiter();
+}
+
+void BandwidthLimiter::setLimits(qint64 globalRate, qint64 transferRate) {
+	global()->setRate(globalRate);
+	m_transferRate = qMax(Q_INT64_C(0), transferRate);
+}
+
+qint64 BandwidthLimiter::rate() const {
+	QMutexLocker lock(&m_mutex);
+	return m_rate;
+}
+
+void BandwidthLimiter::setRate(qint64 rate) {
+
+	QMutexLocker lock(&m_mutex);
+
+	m_rate = qMax(Q_INT64_C(0), rate);
+	m_tokens = m_rate;
+	m_credited = m_clock.elapsed();
+}
+
+void BandwidthLimiter::refill() const {
+
+	const qint64 now = m_clock.elapsed();
+	const qint64 add = (now - m_credited) * m_rate / 1000;
+
+	if(add > 0) {
+		m_tokens = qMin(m_rate, m_tokens + add);
+		m_credited += add * 1000 / m_rate; // keep the fraction for the next call
+	}
+
+	if(m_tokens == m_rate) m_credited = now;
+}
+
+qint64 BandwidthLimiter::available() const {
+
+	QMutexLocker lock(&m_mutex);
+
+	if(!m_rate) return std::numeric_limits<qint64>::max();
+
+	refill();
+
+	return qMax(Q_INT64_C(0), m_tokens);
+}
+
+void BandwidthLimiter::consume(qint64 bytes) {
+
+	QMutexLocker lock(&m_mutex);
+
+	if(m_rate) {
+		refill();
+		m_tokens -= bytes;
+	}
+}
+
+int BandwidthLimiter::delay() const {
+
+	QMutexLocker lock(&m_mutex);
+
+	if(!m_rate) return 0;
+
+	refill();
+
+	if(m_tokens > 0) return 0;
+
+	// at least 10 ms to not spin, at most a second to notice rate changes
+	return static_cast<int>(qBound(Q_INT64_C(10), (1 - m_tokens) * 1000 / m_rate + 1,
+								   Q_INT64_C(1000)));
+}
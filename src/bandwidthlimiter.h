@@ -0,0 +1,66 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BANDWIDTHLIMITER_H
+#define BANDWIDTHLIMITER_H
+
+#include <QMutex>
+#include <QElapsedTimer>
+
+/**
+ * Token bucket limiting the bandwidth
+ *
+ * The bucket holds at most one second worth of tokens. Consuming more than
+ * available is allowed and drives the bucket into debt, which is how
+ * transfers of higher priority take precedence over bulk transfers.
+ */
+class Q_DECL_HIDDEN BandwidthLimiter {
+	Q_DISABLE_COPY(BandwidthLimiter)
+public:
+	explicit BandwidthLimiter(qint64 rate = Q_INT64_C(0));
+
+	static BandwidthLimiter *global();
+
+	static void setLimits(qint64 globalRate, qint64 transferRate);
+
+	inline static qint64 transferRate() {
+		return m_transferRate;
+	}
+
+	qint64 rate() const;
+	void setRate(qint64 rate);
+
+	qint64 available() const;
+	void consume(qint64 bytes);
+	int delay() const;
+
+private:
+	void refill() const;
+
+private:
+	static qint64 m_transferRate;
+
+	mutable QMutex m_mutex;
+	mutable QElapsedTimer m_clock;
+	mutable qint64 m_credited;
+	mutable qint64 m_tokens;
+	qint64 m_rate;
+};
+
+#endif // BANDWIDTHLIMITER_H
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QBuffer>
+#include <QRegExp>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+
+#ifdef HAVE_MKDIO_H
+extern "C" {
+#include <mkdio.h>
+}
+#endif
+
+#include "bodyrenderer.h"
+#include "resourcecache.h"
+#include "qgithubreleaseinstrumentation.h"
+
+BodyRenderer::BodyRenderer(QGitHubReleaseAPI::TYPE type, ResourceCache &resources) :
+	m_type(type), m_resources(resources) {}
+
+const char *BodyRenderer::field(QGitHubReleaseAPI::TYPE type) {
+
+	switch(type) {
+#ifdef HAVE_MKDIO_H
+	case QGitHubReleaseAPI::RAW: return "body";
+#else
+	case QGitHubReleaseAPI::RAW:
+#endif
+	case QGitHubReleaseAPI::HTML: return "body_html";
+	default: return "body_text";
+	}
+}
+
+QString BodyRenderer::render(const QString &body, QString &err) const {
+
+	err = QString::null;
+
+	switch(m_type) {
+#ifdef HAVE_MKDIO_H
+	case QGitHubReleaseAPI::RAW: {
+
+#if QT_VERSION >= QT_VERSION_CHECK(4, 5, 0)
+			const mkd_flag_t f = MKD_TOC|MKD_AUTOLINK|MKD_NOEXT|MKD_NOHEADER;
+#else
+			const mkd_flag_t f = MKD_TOC|MKD_AUTOLINK|MKD_NOEXT|MKD_NOHEADER|MKD_NOIMAGE;
+#endif
+			MMIOT *doc = 0L;
+			char *html = 0L;
+			int dlen   = EOF;
+
+			QElapsedTimer timer;
+			timer.start();
+
+			if((doc = mkd_string(body.toStdString().c_str(), body.length(), f)) &&
+					mkd_compile(doc, f) != EOF && (dlen = mkd_document(doc, &html)) != EOF) {
+
+				QString b(QString::fromUtf8((QByteArray(html, dlen).append('\0')).constData()));
+				mkd_cleanup(doc);
+
+				QGitHubReleaseInstrumentation::instance()->
+						recordPhase(QGitHubReleaseInstrumentation::MARKDOWN, timer.nsecsElapsed());
+
+				return embedImages(b);
+
+			} else {
+				err = QCoreApplication::translate("QGitHubReleaseAPIPrivate",
+												  "libmarkdown: parsing failed");
+			}
+
+		} break;
+#else
+	case QGitHubReleaseAPI::RAW:
+#endif
+	case QGitHubReleaseAPI::HTML: {
+			QString b(body);
+			return embedImages(b);
+		} break;
+	default:
+		return QString(body).append(QString::fromUtf8("\n\n--\nRelease information provided by " \
+													  "QGitHubReleaseAPI "
+													  PROJECTVERSION
+													  " \u00a9 2015 Heiko Sch\u00e4fer " \
+													  "<heiko@rangun.de>"));
+	}
+
+	return QString::null;
+}
+
+QString BodyRenderer::embedImages(QString &b) const {
+
+	QElapsedTimer timer;
+	timer.start();
+
+#if QT_VERSION >= QT_VERSION_CHECK(4, 5, 0)
+
+	QRegExp emjRex(":([_a-zA-Z0-9]+):");
+	QRegExp imgRex("<[^<]*img[^>]*src\\s*=\\s*\"([^\"]*)\"[^>]*>");
+
+	int idx = -1;
+
+	while((idx = b.indexOf(emjRex, idx + 1)) != -1) {
+
+		const QString emjKey(emjRex.cap(1));
+		const QUrl &emjUrl(m_resources.emojiUrl(emjKey));
+
+		if(emjUrl.isValid()) {
+			b.replace(idx, emjKey.length() + 2, "<img width=\"16\" height=\"16\" alt=\"" + emjKey +
+					  "\" src=\"" + emjUrl.toString() + "\">");
+		}
+
+		idx += emjKey.length() + 1;
+	}
+
+	idx = -1;
+
+	while((idx = b.indexOf(imgRex, idx + 1)) != -1) {
+
+		const QUrl url = QUrl(imgRex.cap(1));
+
+		if(url.isValid()) {
+
+			const QImage img = QImage::fromData(m_resources.fetch(url));
+
+			if(!img.isNull()) {
+
+				QByteArray ba;
+				QBuffer buf(&ba);
+				buf.open(QIODevice::WriteOnly);
+				img.save(&buf, "PNG");
+				ba.squeeze();
+
+				b.replace(imgRex.pos(1), imgRex.cap(1).length(),
+						  QString("data:image/png;base64,%1").
+						  arg(ba.toBase64().constData()));
+			}
+		}
+	}
+#endif
+
+	b.append("<hr /><p>Release information provided by " \
+			 "<em>QGitHubReleaseAPI "
+			 PROJECTVERSION
+			 "</em> &copy; 2015 " \
+			 "Heiko Sch&auml;fer &lt;<a href=\"mailto:heiko@rangun.de?" \
+			 "subject=QGitHubReleaseAPI%20"
+			 PROJECTVERSION
+			 "\">heiko@rangun.de</a>&gt;");
+
+#ifdef HAVE_MKDIO_H
+	if(m_type == QGitHubReleaseAPI::RAW) {
+		b.append(QString("<br />Markdown rendered with <em>libmarkdown %1</em>").
+				 arg(markdown_version));
+	}
+#endif
+
+	b.append("</p>");
+
+	QGitHubReleaseInstrumentation::instance()->
+			recordPhase(QGitHubReleaseInstrumentation::EMBED_IMAGES, timer.nsecsElapsed());
+
+	return b;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BODYRENDERER_H
+#define BODYRENDERER_H
+
+#include "qgithubreleaseapi.h"
+
+class ResourceCache;
+
+/**
+ * Renders a release body
+ *
+ * Doesn't depend on any @c QGitHubReleaseAPIPrivate state, thus it can run
+ * in any thread. Images are taken from the @c ResourceCache, which downloads
+ * them within the calling thread.
+ */
+class Q_DECL_HIDDEN BodyRenderer {
+	Q_DISABLE_COPY(BodyRenderer)
+public:
+	BodyRenderer(QGitHubReleaseAPI::TYPE type, ResourceCache &resources);
+
+	static const char *field(QGitHubReleaseAPI::TYPE type);
+
+	QString render(const QString &body, QString &err) const;
+
+private:
+	QString embedImages(QString &b) const;
+
+private:
+	const QGitHubReleaseAPI::TYPE m_type;
+	ResourceCache &m_resources;
+};
+
+#endif // BODYRENDERER_H
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_BROTLI_DECODE_H
+#include <brotli/decode.h>
+#endif
+
+#include "contentdecoder.h"
+
+namespace {
+
+const int CHUNKSIZE = 16384;
+
+#ifdef HAVE_ZLIB_H
+class GZipDecoder : public ContentDecoder {
+public:
+	GZipDecoder() : ContentDecoder(), m_failed(false), m_inStream(false) {
+
+		m_zs.zalloc = Z_NULL;
+		m_zs.zfree  = Z_NULL;
+		m_zs.opaque = Z_NULL;
+		m_zs.next_in  = Z_NULL;
+		m_zs.avail_in = 0;
+
+		// detect the gzip or zlib header automatically
+		m_failed = inflateInit2(&m_zs, MAX_WBITS + 32) != Z_OK;
+	}
+
+	virtual ~GZipDecoder() {
+		if(!m_failed) inflateEnd(&m_zs);
+	}
+
+	virtual bool decode(const QByteArray &in, QByteArray &out) {
+
+		if(m_failed) return false;
+
+		if(!in.isEmpty()) m_inStream = true;
+
+		char buf[CHUNKSIZE];
+
+		m_zs.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(in.constData()));
+		m_zs.avail_in = static_cast<uInt>(in.size());
+
+		for(;;) {
+
+			m_zs.next_out  = reinterpret_cast<Bytef *>(buf);
+			m_zs.avail_out = CHUNKSIZE;
+
+			const int r = inflate(&m_zs, Z_NO_FLUSH);
+
+			if(r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR) {
+				inflateEnd(&m_zs);
+				return !(m_failed = true);
+			}
+
+			out.append(buf, CHUNKSIZE - static_cast<int>(m_zs.avail_out));
+
+			if(r == Z_STREAM_END) {
+				if(!(m_inStream = m_zs.avail_in != 0)) break;
+				inflateReset(&m_zs); // concatenated gzip members
+			} else if(r == Z_BUF_ERROR || (!m_zs.avail_in && m_zs.avail_out)) {
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	virtual bool isFinished() const {
+		return !(m_failed || m_inStream);
+	}
+
+private:
+	z_stream m_zs;
+	bool m_failed;
+	bool m_inStream;
+};
+#endif
+
+#ifdef HAVE_BROTLI_DECODE_H
+class BrotliDecoder : public ContentDecoder {
+public:
+	BrotliDecoder() : ContentDecoder(), m_state(BrotliDecoderCreateInstance(0L, 0L, 0L)),
+		m_started(false) {}
+
+	virtual ~BrotliDecoder() {
+		if(m_state) BrotliDecoderDestroyInstance(m_state);
+	}
+
+	virtual bool decode(const QByteArray &in, QByteArray &out) {
+
+		if(!m_state) return false;
+
+		if(!in.isEmpty()) m_started = true;
+
+		uint8_t buf[CHUNKSIZE];
+		size_t availIn = static_cast<size_t>(in.size());
+		const uint8_t *nextIn = reinterpret_cast<const uint8_t *>(in.constData());
+		BrotliDecoderResult r;
+
+		do {
+
+			size_t availOut = CHUNKSIZE;
+			uint8_t *nextOut = buf;
+
+			r = BrotliDecoderDecompressStream(m_state, &availIn, &nextIn, &availOut, &nextOut,
+											  0L);
+
+			out.append(reinterpret_cast<const char *>(buf),
+					   CHUNKSIZE - static_cast<int>(availOut));
+
+		} while(r == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT);
+
+		if(r == BROTLI_DECODER_RESULT_ERROR) {
+			BrotliDecoderDestroyInstance(m_state);
+			m_state = 0L;
+			return false;
+		}
+
+		return true;
+	}
+
+	virtual bool isFinished() const {
+		return m_state && (!m_started || BrotliDecoderIsFinished(m_state));
+	}
+
+private:
+	BrotliDecoderState *m_state;
+	bool m_started;
+};
+#endif
+
+}
+
+ContentDecoder::ContentDecoder() {}
+
+ContentDecoder::~ContentDecoder() {}
+
+QByteArray ContentDecoder::acceptEncoding() {
+
+	QByteArray ae;
+
+#ifdef HAVE_ZLIB_H
+	ae = "gzip, deflate";
+#endif
+
+#ifdef HAVE_BROTLI_DECODE_H
+	ae += ae.isEmpty() ? "br" : ", br";
+#endif
+
+	return ae;
+}
+
+ContentDecoder *ContentDecoder::create(const QByteArray &contentEncoding) {
+
+	const QByteArray &ce(contentEncoding.trimmed().toLower());
+
+#ifdef HAVE_ZLIB_H
+	if(ce == "gzip" || ce == "x-gzip" || ce == "deflate") return new GZipDecoder();
+#endif
+
+#ifdef HAVE_BROTLI_DECODE_H
+	if(ce == "br") return new BrotliDecoder();
+#endif
+
+	return 0L;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONTENTDECODER_H
+#define CONTENTDECODER_H
+
+#include <QByteArray>
+
+/**
+ * Streaming decoder for a @em Content-Encoding
+ *
+ * The encodings are decoded chunk by chunk as they arrive, thus a compressed
+ * response is never buffered as a whole.
+ */
+class Q_DECL_HIDDEN ContentDecoder {
+	Q_DISABLE_COPY(ContentDecoder)
+public:
+	virtual ~ContentDecoder();
+
+	static QByteArray acceptEncoding();
+	static ContentDecoder *create(const QByteArray &contentEncoding);
+
+	virtual bool decode(const QByteArray &in, QByteArray &out) = 0;
+
+	/// @c true if the stream ended, or if there was no data at all
+	virtual bool isFinished() const = 0;
+
+protected:
+	ContentDecoder();
+};
+
+#endif // CONTENTDECODER_H
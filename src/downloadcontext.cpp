@@ -0,0 +1,231 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QEventLoop>
+
+#include "downloadcontext.h"
+#include "archiveextractor.h"
+#include "filesink.h"
+
+DownloadContext::DownloadContext(QIODevice *of) : QObject(), m_outputFile(of),
+	m_readBytes(Q_INT64_C(0)), m_reply(0L), m_startPos(Q_INT64_C(0)),
+	m_limiter(BandwidthLimiter::transferRate()), m_throttle(), m_pending(), m_bulk(false),
+	m_complete(false), m_loop(0L), m_downloader(0L), m_sink(qobject_cast<FileSink *>(of)) {
+
+	m_throttle.setSingleShot(true);
+	QObject::connect(&m_throttle, SIGNAL(timeout()), this, SLOT(readChunk()));
+}
+
+DownloadContext::~DownloadContext() {}
+
+qint64 DownloadContext::run(const FileDownloader &dl) {
+
+	QEventLoop wait;
+
+	QObject::connect(&dl, SIGNAL(canceled()), &wait, SLOT(quit()));
+	QObject::connect(&dl, SIGNAL(error(QString)), &wait, SLOT(quit()));
+	QObject::connect(&dl, SIGNAL(downloaded(FileDownloader)),
+					 this, SLOT(downloaded(FileDownloader)));
+	QObject::connect(&dl, SIGNAL(canceled()), this, SLOT(failed()));
+	QObject::connect(&dl, SIGNAL(error(QString)), this, SLOT(failed()));
+	QObject::connect(&dl, SIGNAL(replyChanged(QNetworkReply*)),
+					 this, SLOT(updateReply(QNetworkReply*)));
+
+	if(!m_outputFile->isSequential()) m_startPos = m_outputFile->pos();
+
+	m_bulk = dl.priority() == FileDownloader::LOW;
+	m_loop = &wait;
+	m_downloader = &dl;
+
+	updateReply(dl.start(QGitHubReleaseAPI::RAW));
+	wait.exec();
+
+	m_throttle.stop();
+	m_loop = 0L;
+	m_reply = 0L;
+	m_downloader = 0L;
+
+	return m_readBytes;
+}
+
+void DownloadContext::updateReply(QNetworkReply *r) {
+
+	if(m_reply) {
+
+		QObject::disconnect(m_reply, SIGNAL(readyRead()), this, SLOT(readChunk()));
+
+		m_throttle.stop();
+		m_pending.clear();
+
+		ArchiveExtractor *x = qobject_cast<ArchiveExtractor *>(m_outputFile);
+
+		// other sequential devices can't start over, the body would end up twice in them
+		if(m_readBytes > Q_INT64_C(0) && !(x || m_sink || !m_outputFile->isSequential())) {
+			failed();
+			m_reply = r;
+			QMetaObject::invokeMethod(this, "abort", Qt::QueuedConnection);
+			return;
+		}
+
+		// a retried request starts over
+		if(m_readBytes > Q_INT64_C(0)) {
+
+			QFile *f = qobject_cast<QFile *>(m_outputFile);
+
+			if(x ? !x->restart() : m_sink ? !m_sink->reset() :
+					(!m_outputFile->seek(m_startPos) || (f && !f->resize(m_startPos)))) {
+				failed();
+			} else {
+				m_readBytes = Q_INT64_C(0);
+			}
+		}
+	}
+
+	if(m_bulk) {
+
+		const qint64 g = BandwidthLimiter::global()->rate();
+		const qint64 t = m_limiter.rate();
+		const qint64 rate = g && t ? qMin(g, t) : qMax(g, t);
+
+		// let the socket apply back pressure instead of buffering everything
+		if(rate) r->setReadBufferSize(qMax(Q_INT64_C(16384), rate));
+	}
+
+	QObject::connect(r, SIGNAL(readyRead()), this, SLOT(readChunk()));
+	m_reply = r;
+}
+
+bool DownloadContext::accepted() const {
+
+	const int status = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+	// redirect and error bodies don't belong into the file
+	return !status || (status >= 200 && status <= 299);
+}
+
+void DownloadContext::readChunk() {
+
+	// after the download finished only the pending data is left
+	if(!m_reply && m_pending.isEmpty()) return;
+
+	if(m_reply && !accepted()) {
+		m_reply->readAll();
+		return;
+	}
+
+	// the size is known only if the body gets stored as is
+	if(m_sink && m_reply && !m_readBytes && m_reply->rawHeader("Content-Encoding").isEmpty()) {
+
+		const qint64 len = m_reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+
+		if(len > Q_INT64_C(0) && !m_sink->preallocate(len)) {
+			failed();
+			abort();
+			return;
+		}
+	}
+
+	const bool pending = !m_pending.isEmpty();
+	qint64 n = pending ? m_pending.size() : m_reply->bytesAvailable();
+
+	if(m_bulk) {
+
+		n = qMin(n, qMin(m_limiter.available(), BandwidthLimiter::global()->available()));
+
+		if(n <= Q_INT64_C(0)) {
+			m_throttle.start(qMax(m_limiter.delay(), BandwidthLimiter::global()->delay()));
+			return;
+		}
+	}
+
+	QByteArray data;
+	qint64 consumed;
+	bool decoded = true;
+
+	if(pending) {
+		data = m_pending.left(static_cast<int>(n));
+		m_pending.remove(0, data.size());
+		consumed = data.size();
+	} else {
+		const QByteArray &raw(m_reply->read(n));
+		consumed = raw.size();
+		decoded = m_downloader->decode(raw, data);
+	}
+
+	m_limiter.consume(consumed);
+	BandwidthLimiter::global()->consume(consumed);
+
+	const qint64 w = decoded ? m_outputFile->write(data) : Q_INT64_C(-1);
+
+	if(w == Q_INT64_C(-1)) {
+		m_pending.clear();
+		failed();
+		abort();
+	} else if(m_readBytes != Q_INT64_C(-1)) {
+		m_readBytes += w;
+	}
+
+	if(!m_pending.isEmpty() || (!pending && m_reply && m_reply->bytesAvailable() > Q_INT64_C(0))) {
+		m_throttle.start(0);
+	} else if(m_complete && m_loop) {
+		m_loop->quit();
+	}
+}
+
+void DownloadContext::downloaded(const FileDownloader &dl) {
+
+	m_complete = true;
+
+	// a cut off encoded body must not get committed
+	if(!dl.decodeFinished()) failed();
+
+	if(m_reply) {
+
+		QObject::disconnect(m_reply, SIGNAL(readyRead()), this, SLOT(readChunk()));
+
+		// whatever the throttled reads left over got buffered by the downloader
+		if(accepted()) m_pending += dl.downloadedData();
+
+		// gets deleted while the throttled rest is written
+		m_reply = 0L;
+	}
+
+	if(m_pending.isEmpty()) {
+		m_loop->quit();
+	} else {
+		readChunk();
+	}
+}
+
+void DownloadContext::failed() {
+	m_readBytes = Q_INT64_C(-1);
+}
+
+void DownloadContext::abort() {
+
+	if(!m_complete && m_downloader) {
+		// also cancels a retry waiting for its backoff
+		m_downloader->abort();
+	} else if(m_complete && m_loop) {
+		m_pending.clear();
+		failed();
+		m_loop->quit();
+	}
+}
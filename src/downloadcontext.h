@@ -0,0 +1,75 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DOWNLOADCONTEXT_H
+#define DOWNLOADCONTEXT_H
+
+#include "filedownloader.h"
+#include "bandwidthlimiter.h"
+
+QT_FORWARD_DECLARE_CLASS(QEventLoop)
+
+class FileSink;
+
+/**
+ * State of a single file download
+ *
+ * Every download gets its own context, thus overlapping downloads, be it
+ * from nested event loops or from different threads, don't interfere.
+ *
+ * Bulk downloads are read no faster than the global and the per-transfer
+ * bandwidth limits allow, all others are only charged to the global limit.
+ */
+class Q_DECL_HIDDEN DownloadContext : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(DownloadContext)
+public:
+	explicit DownloadContext(QIODevice *outputFile);
+	virtual ~DownloadContext();
+
+	qint64 run(const FileDownloader &dl);
+
+public slots:
+	void abort();
+
+private slots:
+	void readChunk();
+	void updateReply(QNetworkReply *);
+	void downloaded(const FileDownloader &);
+	void failed();
+
+private:
+	bool accepted() const;
+
+private:
+	QIODevice *const m_outputFile;
+	qint64 m_readBytes;
+	QPointer<QNetworkReply> m_reply; ///< the downloader deletes it after it finished
+	qint64 m_startPos;
+	BandwidthLimiter m_limiter;
+	QTimer m_throttle;
+	QByteArray m_pending;
+	bool m_bulk;
+	bool m_complete;
+	QEventLoop *m_loop;
+	const FileDownloader *m_downloader;
+	FileSink *const m_sink;
+};
+
+#endif // DOWNLOADCONTEXT_H
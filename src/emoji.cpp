@@ -20,8 +20,8 @@
 #include "emoji.h"
 #include "entryhelper.h"
 
-Emoji::Emoji(const QString &eTag) : QGitHubReleaseAPIPrivate(QUrl("https://api.github.com/emojis"),
-															 false, QGitHubReleaseAPI::RAW, eTag) {}
+Emoji::Emoji(const QString &eTag) : QGitHubReleaseAPIPrivate(apiEndpoint("/emojis"), false,
+															 QGitHubReleaseAPI::RAW, eTag) {}
 
 Emoji::~Emoji() {}
 
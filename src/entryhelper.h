@@ -33,8 +33,7 @@ public:
 		if(api.dataAvailable()) {
 
 			if(api.entries() > idx) {
-				return subId.isEmpty() ? api.m_vdata[idx].toMap()[id].value<T>() :
-										 api.m_vdata[idx].toMap()[subId].toMap()[id].value<T>();
+				return api.value(idx, id, subId).value<T>();
 			} else {
 				emit api.error(QString(api.m_outOfBoundsError).arg(api.entries()).arg(idx));
 			}
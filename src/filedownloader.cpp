@@ -17,19 +17,180 @@
  * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QSet>
+#include <QHash>
+#include <QMutex>
+#include <QThreadStorage>
+#include <QEventLoop>
+#include <QDateTime>
+#include <QtAlgorithms>
 #include <QSslConfiguration>
+#include <QCryptographicHash>
 
 #include "filedownloader.h"
+#include "bandwidthlimiter.h"
+#include "contentdecoder.h"
+#include "jitter.h"
+
+namespace {
+
+/**
+ * Total times of the most recent successful API requests
+ */
+class LatencyWindow {
+public:
+	LatencyWindow() : m_mutex(), m_samples() {}
+
+	void add(qint64 msecs) {
+
+		QMutexLocker lock(&m_mutex);
+
+		if(m_samples.count() == 100) m_samples.removeFirst();
+
+		m_samples.append(msecs);
+	}
+
+	qint64 percentile(int p, int minSamples) {
+
+		QMutexLocker lock(&m_mutex);
+
+		if(m_samples.count() < qMax(1, minSamples)) return Q_INT64_C(-1);
+
+		QList<qint64> l(m_samples);
+
+		qSort(l);
+
+		return l[(l.count() - 1) * p / 100];
+	}
+
+private:
+	QMutex m_mutex;
+	QList<qint64> m_samples;
+};
+
+/**
+ * Buffered requests in flight, by URL and request headers
+ *
+ * The first requester of a key performs the request, everyone requesting it
+ * meanwhile gets the result delivered by a queued call of @c shared.
+ */
+class FlightRegistry {
+public:
+	FlightRegistry() : m_mutex(), m_flights() {}
+
+	bool join(const QString &key, FileDownloader *dl) {
+
+		QMutexLocker lock(&m_mutex);
+
+		if(!m_flights.contains(key)) {
+			m_flights.insert(key, QList<FileDownloader *>());
+			return true;
+		}
+
+		m_flights[key].append(dl);
+
+		return false;
+	}
+
+	void leave(const QString &key, FileDownloader *dl) {
+
+		QMutexLocker lock(&m_mutex);
+
+		if(m_flights.contains(key)) m_flights[key].removeAll(dl);
+	}
+
+	void land(const QString &key, bool canceled, int httpStatus,
+			  const FileDownloader::RAWHEADERPAIRLIST &headers, const QByteArray &data,
+			  const QString &err) {
+
+		qRegisterMetaType<FileDownloader::RAWHEADERPAIRLIST>("FileDownloader::RAWHEADERPAIRLIST");
+
+		// followers leave under the lock, thus none gets deleted meanwhile
+		QMutexLocker lock(&m_mutex);
+
+		foreach(FileDownloader *dl, m_flights.take(key)) {
+			QMetaObject::invokeMethod(dl, "shared", Qt::QueuedConnection,
+									  Q_ARG(bool, canceled), Q_ARG(int, httpStatus),
+									  Q_ARG(FileDownloader::RAWHEADERPAIRLIST, headers),
+									  Q_ARG(QByteArray, data), Q_ARG(QString, err));
+		}
+	}
+
+private:
+	QMutex m_mutex;
+	QHash<QString, QList<FileDownloader *> > m_flights;
+};
+
+/**
+ * Hosts which failed to speak HTTP/2
+ */
+class HostSet {
+public:
+	HostSet() : m_mutex(), m_hosts() {}
+
+	void insert(const QString &host) {
+		QMutexLocker lock(&m_mutex);
+		m_hosts.insert(host);
+	}
+
+	bool contains(const QString &host) {
+		QMutexLocker lock(&m_mutex);
+		return m_hosts.contains(host);
+	}
+
+private:
+	QMutex m_mutex;
+	QSet<QString> m_hosts;
+};
+
+struct UrlRewriter {
+
+	UrlRewriter() : mutex(), rewriter(0L), userData(0L) {}
+
+	QMutex mutex;
+	QGitHubReleaseAPI::URLREWRITER rewriter;
+	void *userData;
+};
+
+}
+
+Q_GLOBAL_STATIC(LatencyWindow, latencyWindow)
+Q_GLOBAL_STATIC(HostSet, http1Hosts)
+Q_GLOBAL_STATIC(FlightRegistry, flights)
+Q_GLOBAL_STATIC(UrlRewriter, urlRewriter)
+
+// one manager per thread, so requests to the same host share their connections
+Q_GLOBAL_STATIC(QThreadStorage<QNetworkAccessManager *>, managers)
+
+int FileDownloader::m_maxAttempts     = 1;
+int FileDownloader::m_retryBaseDelay  = 500;
+int FileDownloader::m_retryMaxDelay   = 30000;
+int FileDownloader::m_hedgePercentile = 0;
+int FileDownloader::m_hedgeMinSamples = 20;
+int FileDownloader::m_connectTimeout  = 30000;
+int FileDownloader::m_idleTimeout     = 60000;
+int FileDownloader::m_totalTimeout    = 0;
+int FileDownloader::m_minThroughput   = 0;
+int FileDownloader::m_throughputWindow = 10000;
+bool FileDownloader::m_http2Enabled   = false;
 
 FileDownloader::FileDownloader(const QUrl &url, const char *userAgent, const QString &eTag,
-							   QObject *p) : QObject(p), m_WebCtrl(), m_DownloadedData(),
-	m_url(url), m_rawHeaderPairs(), m_reply(0L), m_request(url), m_userAgent(userAgent),
-	m_generic(false) {
+							   QObject *p) : QObject(p), m_DownloadedData(),
+	m_url(rewrite(url)), m_rawHeaderPairs(), m_reply(0L), m_request(m_url), m_userAgent(userAgent),
+	m_generic(false), m_httpStatus(0), m_timer(), m_stats(), m_hedge(0L), m_hedgeTimer(this),
+	m_buffered(false), m_attempt(0), m_retryTimer(this), m_watchdog(this), m_timedOut(NONE),
+	m_responded(false), m_attemptStart(Q_INT64_C(0)), m_lastActivity(Q_INT64_C(0)),
+	m_windowStart(Q_INT64_C(0)), m_windowBytes(Q_INT64_C(0)), m_priority(NORMAL), m_decoder(0L),
+	m_decodeFailed(false), m_flightKey(), m_leader(false) {
 
-	moveToThread(m_WebCtrl.thread());
+	m_hedgeTimer.setSingleShot(true);
+	QObject::connect(&m_hedgeTimer, SIGNAL(timeout()), this, SLOT(hedge()));
 
-	QObject::connect(&m_WebCtrl, SIGNAL(finished(QNetworkReply*)),
-					 SLOT(fileDownloaded(QNetworkReply*)));
+	m_retryTimer.setSingleShot(true);
+	QObject::connect(&m_retryTimer, SIGNAL(timeout()), this, SLOT(retry()));
+
+	m_watchdog.setInterval(1000);
+	QObject::connect(&m_watchdog, SIGNAL(timeout()), this, SLOT(watchdog()));
 
 	QSslConfiguration cnf(m_request.sslConfiguration());
 
@@ -39,13 +200,36 @@ FileDownloader::FileDownloader(const QUrl &url, const char *userAgent, const QSt
 	m_request.setSslConfiguration(cnf);
 	m_request.setRawHeader("User-Agent", QByteArray(userAgent));
 
-	if(!eTag.isEmpty()) m_request.setRawHeader("If-None-Match", eTag.toLatin1());
+	const QByteArray &ae(ContentDecoder::acceptEncoding());
+
+	// without it QNetworkAccessManager decompresses gzip itself, but only when finished
+	if(!ae.isEmpty()) m_request.setRawHeader("Accept-Encoding", ae);
+
+	setETag(eTag);
 
 	m_request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
 						   QNetworkRequest::AlwaysNetwork);
 }
 
-FileDownloader::~FileDownloader() {}
+FileDownloader::~FileDownloader() {
+
+	if(m_leader) {
+		land(true, QString::null);
+	} else if(!m_flightKey.isEmpty()) {
+		flights()->leave(m_flightKey, this);
+	}
+
+	// the replies belong to the shared manager
+	foreach(QNetworkReply *r, QList<QNetworkReply *>() << m_reply.data() << m_hedge) {
+		if(r) {
+			QObject::disconnect(r, 0, this, 0);
+			r->abort();
+			r->deleteLater();
+		}
+	}
+
+	delete m_decoder;
+}
 
 QNetworkReply *FileDownloader::start(QGitHubReleaseAPI::TYPE type) const {
 
@@ -61,33 +245,442 @@ QNetworkReply *FileDownloader::start(QGitHubReleaseAPI::TYPE type) const {
 	case QGitHubReleaseAPI::TEXT: sType = "text"; break;
 	}
 
-	m_request.setRawHeader("Accept", !m_generic ?
-							   QByteArray(QString("application/vnd.github.v3.%1+json").
-										  arg(sType).toLatin1()) :
-							   QByteArray("application/octet-stream"));
+	return start(!m_generic ? QString("application/vnd.github.v3.%1+json").arg(sType).toLatin1() :
+							  QByteArray("application/octet-stream"));
+}
+
+QNetworkReply *FileDownloader::start(const QByteArray &accept) const {
+
+	m_request.setRawHeader("Accept", accept);
+
+	return launch();
+}
+
+void FileDownloader::setToken(const QByteArray &token) {
+	m_request.setRawHeader("Authorization", token.isEmpty() ? QByteArray() :
+															  QByteArray("token ") + token);
+}
+
+QNetworkReply *FileDownloader::launch() const {
+
+	m_stats = QGitHubReleaseRequestStats();
+	m_stats.url = m_url;
+	m_attempt = 1;
+	m_timedOut = NONE;
+	m_timer.start();
 
-	m_reply = m_WebCtrl.get(m_request);
+	if(m_buffered) {
+
+		const QByteArray &auth(m_request.rawHeader("Authorization"));
+
+		// requests with other credentials may get another response
+		m_flightKey = m_url.toString() + QLatin1Char('\n') +
+				QString(m_request.rawHeader("Accept")) + QLatin1Char('\n') +
+				QString(m_request.rawHeader("If-None-Match")) + QLatin1Char('\n') +
+				QString(auth.isEmpty() ? QByteArray() :
+										 QCryptographicHash::hash(auth, QCryptographicHash::Sha1).
+										 toHex());
+
+		m_leader = flights()->join(m_flightKey, const_cast<FileDownloader *>(this));
+
+		if(!m_leader) return 0L;
+	}
+
+	m_reply = get();
+	connectReply();
+
+	if(m_buffered && m_hedgePercentile > 0) {
+
+		const qint64 t = latencyWindow()->percentile(m_hedgePercentile, m_hedgeMinSamples);
+
+		if(t >= 0) m_hedgeTimer.start(static_cast<int>(t));
+	}
+
+	return m_reply;
+}
+
+void FileDownloader::setRetryPolicy(int maxAttempts, int baseDelay, int maxDelay) {
+	m_maxAttempts    = qMax(1, maxAttempts);
+	m_retryBaseDelay = qMax(0, baseDelay);
+	m_retryMaxDelay  = qMax(m_retryBaseDelay, maxDelay);
+}
+
+void FileDownloader::setHedging(int percentile, int minSamples) {
+	m_hedgePercentile = qBound(0, percentile, 100);
+	m_hedgeMinSamples = minSamples;
+}
+
+void FileDownloader::setHttp2Enabled(bool enabled) {
+	m_http2Enabled = enabled;
+}
+
+void FileDownloader::setUrlRewriter(QGitHubReleaseAPI::URLREWRITER rewriter, void *userData) {
+	QMutexLocker lock(&urlRewriter()->mutex);
+	urlRewriter()->rewriter = rewriter;
+	urlRewriter()->userData = userData;
+}
+
+QUrl FileDownloader::rewrite(const QUrl &url) {
+
+	urlRewriter()->mutex.lock();
+
+	const QGitHubReleaseAPI::URLREWRITER rewriter = urlRewriter()->rewriter;
+	void *const userData = urlRewriter()->userData;
+
+	urlRewriter()->mutex.unlock();
+
+	return rewriter ? rewriter(url, userData) : url;
+}
+
+void FileDownloader::setTimeouts(int connectTimeout, int idleTimeout, int totalTimeout) {
+	m_connectTimeout = qMax(0, connectTimeout);
+	m_idleTimeout    = qMax(0, idleTimeout);
+	m_totalTimeout   = qMax(0, totalTimeout);
+}
+
+void FileDownloader::setMinThroughput(int bytesPerSecond, int window) {
+	m_minThroughput    = qMax(0, bytesPerSecond);
+	m_throughputWindow = qMax(1000, window);
+}
+
+bool FileDownloader::isTransient(const QNetworkReply *r) {
+
+	const int status = r->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+	if(status == 429 || (status >= 500 && status < 600)) return true;
+
+	switch(r->error()) {
+	case QNetworkReply::RemoteHostClosedError:
+	case QNetworkReply::TimeoutError:
+	case QNetworkReply::TemporaryNetworkFailureError:
+	case QNetworkReply::ProxyTimeoutError:
+	case QNetworkReply::UnknownNetworkError:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool FileDownloader::isProtocolError(const QNetworkReply *r) {
+
+	switch(r->error()) {
+	case QNetworkReply::ProtocolUnknownError:
+	case QNetworkReply::ProtocolInvalidOperationError:
+	case QNetworkReply::ProtocolFailure:
+		return true;
+	default:
+		return false;
+	}
+}
+
+int FileDownloader::retryDelay(const QNetworkReply *r, int attempt) {
+
+	const qint64 cap = qMin(static_cast<qint64>(m_retryMaxDelay),
+							static_cast<qint64>(m_retryBaseDelay) << qMin(attempt - 1, 20));
+
+	// full jitter, but never earlier than the server asked for
+	const qint64 retryAfter = r->rawHeader("Retry-After").toLongLong() * 1000;
+
+	return static_cast<int>(qMax(retryAfter, Jitter::bounded(cap + 1)));
+}
+
+void FileDownloader::retry() {
+
+	QObject::disconnect(m_reply, 0, this, 0);
+	m_reply->deleteLater();
+
+	++m_attempt;
+	++m_stats.retries;
+	m_timedOut = NONE;
+
+	m_reply = get();
+	connectReply();
+
+	emit replyChanged(m_reply);
+}
+
+void FileDownloader::hedge() {
+
+#if QT_VERSION >= QT_VERSION_CHECK(4, 5, 0)
+	if(m_hedge || !m_reply->isRunning()) return;
+#else
+	if(m_hedge) return;
+#endif
+
+	m_stats.hedged = true;
+	m_hedge = get();
+}
+
+void FileDownloader::connectReply() const {
+
+	m_responded = false;
+	m_stats.bytesReceived = Q_INT64_C(0);
+
+	delete m_decoder;
+	m_decoder = ContentDecoder::create(m_reply->rawHeader("Content-Encoding"));
+	m_decodeFailed = false;
+	m_DownloadedData.clear();
+
+	if(m_buffered) QObject::connect(m_reply, SIGNAL(readyRead()), this, SLOT(readyRead()));
+
+	m_attemptStart = m_lastActivity = m_windowStart = m_timer.elapsed();
+	m_windowBytes = Q_INT64_C(0);
+
+	if(m_connectTimeout || m_idleTimeout || m_totalTimeout || m_minThroughput) {
+		m_watchdog.start();
+	}
 
 	QObject::connect(m_reply, SIGNAL(downloadProgress(qint64,qint64)),
 					 this, SLOT(downloadProgress(qint64,qint64)));
+	QObject::connect(m_reply, SIGNAL(metaDataChanged()), this, SLOT(metaDataChanged()));
+#if QT_VERSION >= QT_VERSION_CHECK(5, 1, 0)
+	QObject::connect(m_reply, SIGNAL(encrypted()), this, SLOT(encrypted()));
+#endif
+}
 
-	return m_reply;
+void FileDownloader::metaDataChanged() {
+
+	m_stats.ttfb = m_lastActivity = m_timer.elapsed();
+
+	if(!m_decoder) m_decoder = ContentDecoder::create(m_reply->rawHeader("Content-Encoding"));
+
+	if(!m_responded) {
+		m_responded = true;
+		m_windowStart = m_lastActivity;
+	}
+}
+
+void FileDownloader::watchdog() {
+
+	const qint64 now = m_timer.elapsed();
+
+	if(m_totalTimeout && now > m_totalTimeout) {
+		m_timedOut = TOTAL;
+	} else if(m_connectTimeout && !m_responded && now - m_attemptStart > m_connectTimeout) {
+		m_timedOut = CONNECT;
+	} else if(m_idleTimeout && now - m_lastActivity > m_idleTimeout) {
+		m_timedOut = IDLE;
+	} else if(m_minThroughput && m_priority != LOW && m_responded &&
+			  now - m_windowStart >= m_throughputWindow) {
+
+		const qint64 bytes = m_stats.bytesReceived - m_windowBytes;
+
+		if(bytes * 1000 < m_minThroughput * (now - m_windowStart)) {
+			m_timedOut = THROUGHPUT;
+		} else {
+			m_windowStart = now;
+			m_windowBytes = m_stats.bytesReceived;
+		}
+	}
+
+	if(m_timedOut != NONE) {
+
+		m_watchdog.stop();
+		m_hedgeTimer.stop();
+
+		if(m_hedge) {
+			QNetworkReply *h = m_hedge;
+			m_hedge = 0L;
+			h->abort();
+		}
+
+		m_reply->abort();
+	}
+}
+
+QString FileDownloader::timeoutError() const {
+
+	switch(m_timedOut) {
+	case CONNECT:
+		return QString("Timeout: no response within %1 ms").arg(m_connectTimeout);
+	case IDLE:
+		return QString("Timeout: no data received within %1 ms").arg(m_idleTimeout);
+	case THROUGHPUT:
+		return QString("Timeout: throughput below %1 bytes/s").arg(m_minThroughput);
+	case TOTAL:
+		return QString("Timeout: not finished within %1 ms").arg(m_totalTimeout);
+	default:
+		return QString::null;
+	}
+}
+
+void FileDownloader::encrypted() {
+	m_stats.tlsTime = m_timer.elapsed();
+}
+
+void FileDownloader::finishStats(bool failed) {
+
+	m_stats.failed = failed;
+	m_stats.timedOut = m_timedOut != NONE;
+	m_stats.totalTime = m_timer.elapsed();
+	m_stats.httpStatus = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	m_stats.notModified = m_stats.httpStatus == 304;
+	m_stats.fromCache = m_reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+	m_stats.http2 = m_reply->attribute(QNetworkRequest::HTTP2WasUsedAttribute).toBool();
+#endif
+
+	if(m_reply->hasRawHeader("X-RateLimit-Limit")) {
+		m_stats.rateLimit = QString(m_reply->rawHeader("X-RateLimit-Limit")).toInt();
+		m_stats.rateLimitRemaining = QString(m_reply->rawHeader("X-RateLimit-Remaining")).toInt();
+		m_stats.rateLimitReset =
+				QDateTime::fromTime_t(QString(m_reply->rawHeader("X-RateLimit-Reset")).toUInt());
+	}
+
+	QGitHubReleaseInstrumentation::instance()->record(m_stats);
+}
+
+QByteArray FileDownloader::fetch(const QUrl &url, const char *userAgent, PRIORITY priority) {
+
+	QEventLoop wait;
+	FileDownloader dl(url, userAgent);
+
+	dl.setCacheLoadControlAttribute(QNetworkRequest::PreferCache);
+	dl.setBuffered(true);
+	dl.setPriority(priority);
+
+	QObject::connect(&dl, SIGNAL(canceled()), &wait, SLOT(quit()));
+	QObject::connect(&dl, SIGNAL(error(QString)), &wait, SLOT(quit()));
+	QObject::connect(&dl, SIGNAL(downloaded(FileDownloader)), &wait, SLOT(quit()));
+
+	dl.start(QGitHubReleaseAPI::RAW);
+	wait.exec();
+
+	return dl.downloadedData();
 }
 
 void FileDownloader::setCacheLoadControlAttribute(QNetworkRequest::CacheLoadControl att) {
 	m_request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, att);
 }
 
+void FileDownloader::setPriority(PRIORITY priority) {
+
+	m_priority = priority;
+
+#if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
+	switch(priority) {
+	case HIGH:   m_request.setPriority(QNetworkRequest::HighPriority); break;
+	case NORMAL: m_request.setPriority(QNetworkRequest::NormalPriority); break;
+	case LOW:    m_request.setPriority(QNetworkRequest::LowPriority); break;
+	}
+#endif
+}
+
+void FileDownloader::setETag(const QString &eTag) {
+	m_request.setRawHeader("If-None-Match", eTag.isEmpty() ? QByteArray() : eTag.toLatin1());
+}
+
 void FileDownloader::downloadProgress(qint64 bytesReceived, qint64 bytesTotal) {
+	m_lastActivity = m_timer.elapsed();
+
+	if(m_buffered && bytesReceived > m_stats.bytesReceived) {
+		BandwidthLimiter::global()->consume(bytesReceived - m_stats.bytesReceived);
+	}
+
+	m_stats.bytesReceived = bytesReceived;
 	emit progress(bytesReceived, bytesTotal);
 }
 
+QNetworkAccessManager *FileDownloader::manager() {
+
+	QThreadStorage<QNetworkAccessManager *> *m = managers();
+
+	if(!m->hasLocalData()) m->setLocalData(new QNetworkAccessManager());
+
+	return m->localData();
+}
+
+QNetworkReply *FileDownloader::get() const {
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+	// Qt falls back to HTTP/1.1 itself if the server doesn't offer HTTP/2
+	m_request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute,
+						   m_http2Enabled && !http1Hosts()->contains(m_url.host()));
+#endif
+
+	QNetworkReply *r = manager()->get(m_request);
+
+	QObject::connect(r, SIGNAL(finished()), this, SLOT(replyFinished()));
+
+	return r;
+}
+
+void FileDownloader::replyFinished() {
+	fileDownloaded(qobject_cast<QNetworkReply *>(sender()));
+}
+
 void FileDownloader::fileDownloaded(QNetworkReply *pReply) {
 
+	// the loser of a hedged request
+	if(pReply != m_reply && pReply != m_hedge) {
+		pReply->deleteLater();
+		return;
+	}
+
+	if(m_hedge) {
+
+		QNetworkReply *other = pReply == m_reply ? m_hedge : m_reply.data();
+
+		m_hedge = 0L;
+
+		if(pReply->error() != QNetworkReply::NoError &&
+				pReply->error() != QNetworkReply::OperationCanceledError) {
+			if(pReply == m_reply) {
+				QObject::disconnect(m_reply, 0, this, 0);
+				m_reply = other; // the hedge decides
+				connectReply();
+			}
+
+			pReply->deleteLater();
+			return;
+		}
+
+		if(pReply != m_reply) {
+			QObject::disconnect(m_reply, 0, this, 0);
+			m_reply = pReply;
+			connectReply();
+		}
+
+		other->abort();
+		other->deleteLater();
+	}
+
+	m_hedgeTimer.stop();
+	m_watchdog.stop();
+
 	if(m_reply->error() != QNetworkReply::NoError) {
 
-		if(m_reply->error() != QNetworkReply::OperationCanceledError) {
-			emit error(m_reply->errorString());
+		const bool canceled = m_timedOut == NONE &&
+				m_reply->error() == QNetworkReply::OperationCanceledError;
+		const QString err(m_timedOut == NONE ? m_reply->errorString() : timeoutError());
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+		if(m_timedOut == NONE && isProtocolError(m_reply) &&
+				m_request.attribute(QNetworkRequest::HTTP2AllowedAttribute).toBool()) {
+			qWarning("HTTP/2 failed for %s, using HTTP/1.1: %s", qPrintable(m_url.host()),
+					 qPrintable(err));
+			http1Hosts()->insert(m_url.host());
+			--m_attempt; // not the server's fault
+			m_retryTimer.start(0);
+			return;
+		}
+#endif
+
+		if(!canceled && m_attempt < m_maxAttempts &&
+				(m_timedOut == NONE ? isTransient(m_reply) : m_timedOut != TOTAL)) {
+			qWarning("Retrying %s: %s", qPrintable(m_url.toString()), qPrintable(err));
+			m_retryTimer.start(retryDelay(m_reply, m_attempt));
+			return;
+		}
+
+		finishStats(true);
+
+		m_reply->deleteLater();
+
+		land(canceled, err);
+
+		if(!canceled) {
+			emit error(err);
 		} else {
 			emit canceled();
 		}
@@ -99,22 +692,29 @@ void FileDownloader::fileDownloaded(QNetworkReply *pReply) {
 
 		if(!redirectTarget.isNull()) {
 
-			m_url = m_url.resolved(redirectTarget.toUrl());
+			const QString host(m_url.host());
+
+			m_url = rewrite(m_url.resolved(redirectTarget.toUrl()));
 			qWarning("Redirect to: %s", qPrintable(m_url.toString()));
 
-			QObject::disconnect(m_reply, SIGNAL(downloadProgress(qint64,qint64)),
-								this, SLOT(downloadProgress(qint64,qint64)));
+			// storage hosts reject a token besides their signed URLs
+			if(m_url.host() != host) m_request.setRawHeader("Authorization", QByteArray());
+
+			QObject::disconnect(m_reply, 0, this, 0);
+
+			++m_stats.redirects;
 
 			m_reply->deleteLater();
 			m_request.setUrl(m_url);
-			m_reply = m_WebCtrl.get(m_request);
-
-			QObject::connect(m_reply, SIGNAL(downloadProgress(qint64,qint64)),
-							 this, SLOT(downloadProgress(qint64,qint64)));
+			m_reply = get();
+			connectReply();
 
 			emit replyChanged(m_reply);
 
 		} else {
+
+			m_httpStatus = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
 #if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
 			m_rawHeaderPairs = m_reply->rawHeaderPairs();
 #else
@@ -125,9 +725,29 @@ void FileDownloader::fileDownloaded(QNetworkReply *pReply) {
 			}
 #endif
 
-			m_DownloadedData = pReply->readAll();
+			// a truncated body can be framed correctly, but its stream didn't end
+			if(!decode(m_reply->readAll(), m_DownloadedData) || !decodeFinished()) {
+				m_decodeFailed = true;
+			}
+
+			finishStats(m_decodeFailed);
+
+			if(m_decodeFailed) {
+
+				const QString err(QString("Failed to decode the %1 encoded response").
+								  arg(QString(m_reply->rawHeader("Content-Encoding"))));
+
+				m_reply->deleteLater();
+				land(false, err);
+
+				emit error(err);
+				return;
+			}
+
+			if(!m_generic) latencyWindow()->add(m_stats.totalTime);
 
 			m_reply->deleteLater();
+			land(false, QString::null);
 
 			emit downloaded(*this);
 		}
@@ -138,8 +758,102 @@ const QByteArray &FileDownloader::downloadedData() const {
 	return m_DownloadedData;
 }
 
+bool FileDownloader::decode(const QByteArray &in, QByteArray &out) const {
+
+	if(!m_decoder) {
+		out.append(in);
+		return true;
+	}
+
+	return !m_decodeFailed && m_decoder->decode(in, out);
+}
+
+bool FileDownloader::decodeFinished() const {
+	return !m_decoder || m_decoder->isFinished();
+}
+
+void FileDownloader::land(bool canceled, const QString &err) {
+
+	if(m_leader) {
+		flights()->land(m_flightKey, canceled, m_httpStatus, m_rawHeaderPairs, m_DownloadedData,
+						err);
+		m_leader = false;
+		m_flightKey.clear();
+	}
+}
+
+void FileDownloader::shared(bool canceled, int httpStatus,
+							const FileDownloader::RAWHEADERPAIRLIST &headers,
+							const QByteArray &data, const QString &err) {
+
+	if(m_flightKey.isEmpty() || m_leader) return; // aborted meanwhile
+
+	m_flightKey.clear();
+
+	// the leader got canceled, but we didn't
+	if(canceled) {
+		launch();
+		return;
+	}
+
+	m_stats.coalesced = true;
+	m_stats.failed = !err.isNull();
+	m_stats.httpStatus = httpStatus;
+	m_stats.notModified = httpStatus == 304;
+	m_stats.totalTime = m_timer.elapsed();
+
+	QGitHubReleaseInstrumentation::instance()->record(m_stats);
+
+	if(!err.isNull()) {
+		emit error(err);
+	} else {
+		m_httpStatus = httpStatus;
+		m_rawHeaderPairs = headers;
+		m_DownloadedData = data;
+		emit downloaded(*this);
+	}
+}
+
+void FileDownloader::readyRead() {
+	if(!decode(m_reply->readAll(), m_DownloadedData)) m_decodeFailed = true;
+}
+
 void FileDownloader::abort() const {
-	m_reply->abort();
+
+	if(!m_leader && !m_flightKey.isEmpty()) {
+		flights()->leave(m_flightKey, const_cast<FileDownloader *>(this));
+		m_flightKey.clear();
+		QMetaObject::invokeMethod(const_cast<FileDownloader *>(this), "canceled",
+								  Qt::QueuedConnection);
+		return;
+	}
+
+	// the last attempt failed already, cancel the next one
+	if(m_retryTimer.isActive()) {
+
+		FileDownloader *self = const_cast<FileDownloader *>(this);
+
+		m_retryTimer.stop();
+		self->finishStats(true);
+
+		QObject::disconnect(m_reply, 0, this, 0);
+		m_reply->deleteLater();
+
+		self->land(true, QString::null);
+
+		QMetaObject::invokeMethod(self, "canceled", Qt::QueuedConnection);
+		return;
+	}
+
+	m_hedgeTimer.stop();
+
+	if(m_hedge) {
+		QNetworkReply *h = m_hedge;
+		m_hedge = 0L;
+		h->abort();
+	}
+
+	if(m_reply) m_reply->abort();
 }
 
 void FileDownloader::cancel(const FileDownloader &fd) {
@@ -20,9 +20,14 @@
 #ifndef FILEDOWNLOADER_H
 #define FILEDOWNLOADER_H
 
+#include <QTimer>
+#include <QPointer>
 #include <QNetworkReply>
+#include <QElapsedTimer>
 
-#include "qgithubreleaseapi.h"
+#include "qgithubreleaseinstrumentation.h"
+
+class ContentDecoder;
 
 class Q_DECL_HIDDEN FileDownloader : public QObject {
 	Q_OBJECT
@@ -35,11 +40,47 @@ public:
 #endif
 	typedef QList<RAWHEADERPAIR> RAWHEADERPAIRLIST;
 
+	typedef enum { HIGH, ///< latency sensitive, i.e. API requests and avatars
+				   NORMAL, ///< images embedded into bodies
+				   LOW ///< bulk transfers, subject to the bandwidth limits
+				 } PRIORITY;
+
 	FileDownloader(const QUrl &url, const char *userAgent, const QString &eTag = QString::null,
 				   QObject *parent = 0L);
 	virtual ~FileDownloader();
 
 	QNetworkReply *start(QGitHubReleaseAPI::TYPE type) const;
+	QNetworkReply *start(const QByteArray &accept) const;
+
+	static QByteArray fetch(const QUrl &url, const char *userAgent, PRIORITY priority = NORMAL);
+
+	static void setRetryPolicy(int maxAttempts, int baseDelay, int maxDelay);
+	static void setHedging(int percentile, int minSamples);
+	static void setTimeouts(int connectTimeout, int idleTimeout, int totalTimeout);
+	static void setMinThroughput(int bytesPerSecond, int window);
+	static void setHttp2Enabled(bool enabled);
+	static void setUrlRewriter(QGitHubReleaseAPI::URLREWRITER rewriter, void *userData);
+
+	/// the URL to request instead of @c url
+	static QUrl rewrite(const QUrl &url);
+
+	inline static int maxAttempts() {
+		return m_maxAttempts;
+	}
+
+	inline static int connectTimeout() {
+		return m_connectTimeout;
+	}
+
+	inline static int idleTimeout() {
+		return m_idleTimeout;
+	}
+
+	/// the network manager of the calling thread, shared by all its requests
+	static QNetworkAccessManager *manager();
+
+	static bool isTransient(const QNetworkReply *r);
+	static int retryDelay(const QNetworkReply *r, int attempt);
 
 	inline QString userAgent() const {
 		return m_userAgent;
@@ -49,7 +90,30 @@ public:
 		m_generic = b;
 	}
 
+	/// authenticates with @c token, but not towards the hosts redirected to
+	void setToken(const QByteArray &token);
+
+	/**
+	 * Marks the response to be consumed only via @c downloadedData, i.e. nobody
+	 * reads from the reply before @c downloaded got emitted. Such requests may
+	 * be hedged and are charged to the global bandwidth limit here.
+	 */
+	inline void setBuffered(bool b) {
+		m_buffered = b;
+	}
+
+	void setPriority(PRIORITY priority);
+
+	inline PRIORITY priority() const {
+		return m_priority;
+	}
+
 	void setCacheLoadControlAttribute(QNetworkRequest::CacheLoadControl att);
+	void setETag(const QString &eTag);
+
+	inline int httpStatus() const {
+		return m_httpStatus;
+	}
 
 	inline QUrl url() const {
 		return m_url;
@@ -57,6 +121,15 @@ public:
 
 	const QByteArray &downloadedData() const;
 
+	/**
+	 * Decodes a chunk read from the current reply according to its
+	 * @em Content-Encoding, the chunks have to be passed in order
+	 */
+	bool decode(const QByteArray &in, QByteArray &out) const;
+
+	/// @c true unless the encoded response got cut off, i.e. the stream didn't end
+	bool decodeFinished() const;
+
 	inline RAWHEADERPAIRLIST rawHeaderPairs() const {
 		return m_rawHeaderPairs;
 	}
@@ -73,18 +146,73 @@ public slots:
 	void abort() const;
 
 private slots:
-	void fileDownloaded(QNetworkReply *pReply);
+	void replyFinished();
 	void downloadProgress(qint64, qint64);
+	void metaDataChanged();
+	void encrypted();
+	void retry();
+	void hedge();
+	void watchdog();
+	void readyRead();
+	void shared(bool canceled, int httpStatus, const FileDownloader::RAWHEADERPAIRLIST &headers,
+				const QByteArray &data, const QString &err);
 
 private:
-	mutable QNetworkAccessManager m_WebCtrl;
-	QByteArray m_DownloadedData;
+	typedef enum { NONE, CONNECT, IDLE, THROUGHPUT, TOTAL } TIMEOUT;
+
+	QNetworkReply *launch() const;
+	QNetworkReply *get() const;
+	void land(bool canceled, const QString &err);
+	void fileDownloaded(QNetworkReply *pReply);
+	void connectReply() const;
+	void finishStats(bool failed);
+	static bool isProtocolError(const QNetworkReply *r);
+	QString timeoutError() const;
+
+private:
+	static int m_maxAttempts;
+	static int m_retryBaseDelay;
+	static int m_retryMaxDelay;
+	static int m_hedgePercentile;
+	static int m_hedgeMinSamples;
+	static int m_connectTimeout;
+	static int m_idleTimeout;
+	static int m_totalTimeout;
+	static int m_minThroughput;
+	static int m_throughputWindow;
+	static bool m_http2Enabled;
+
+	mutable QByteArray m_DownloadedData;
 	QUrl m_url;
 	RAWHEADERPAIRLIST m_rawHeaderPairs;
-	mutable QNetworkReply *m_reply;
+	mutable QPointer<QNetworkReply> m_reply;
 	mutable QNetworkRequest m_request;
 	QString m_userAgent;
 	bool m_generic;
+	int m_httpStatus;
+	mutable QElapsedTimer m_timer;
+	mutable QGitHubReleaseRequestStats m_stats;
+	mutable QNetworkReply *m_hedge;
+	mutable QTimer m_hedgeTimer;
+	bool m_buffered;
+	mutable int m_attempt;
+	mutable QTimer m_retryTimer;
+	mutable QTimer m_watchdog;
+	mutable TIMEOUT m_timedOut;
+	mutable bool m_responded;
+	mutable qint64 m_attemptStart;
+	mutable qint64 m_lastActivity;
+	mutable qint64 m_windowStart;
+	mutable qint64 m_windowBytes;
+	PRIORITY m_priority;
+	mutable ContentDecoder *m_decoder;
+	mutable bool m_decodeFailed;
+	mutable QString m_flightKey;
+	mutable bool m_leader;
 };
 
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_DECLARE_METATYPE(FileDownloader::RAWHEADERPAIRLIST)
+#endif
+
 #endif // FILEDOWNLOADER_H
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cerrno>
+
+#include <QtGlobal>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <io.h>
+#elif defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <QDir>
+#include <QFileInfo>
+
+#include "filesink.h"
+
+namespace {
+
+const int BLOCKSIZE = 1048576;
+
+bool syncFile(int fd) {
+#if defined(Q_OS_WIN)
+	return !_commit(fd);
+#elif defined(Q_OS_UNIX)
+	return !fsync(fd);
+#else
+	Q_UNUSED(fd)
+	return true;
+#endif
+}
+
+}
+
+FileSink::FileSink(const QString &fileName) : QIODevice(),
+	m_fileName(QFileInfo(fileName).absoluteFilePath()),
+	m_tmp(QString(QFileInfo(m_fileName).absolutePath() + "/." +
+				  QFileInfo(m_fileName).fileName() + ".XXXXXX")), m_buf(),
+	m_written(Q_INT64_C(0)), m_committed(false), m_failed(false) {}
+
+FileSink::~FileSink() {
+	close();
+}
+
+bool FileSink::open(OpenMode mode) {
+
+	if((mode & ReadOnly) || !(mode & WriteOnly)) {
+		setErrorString("the download can only be written");
+		return false;
+	}
+
+	if(!m_tmp.open()) {
+		setErrorString(m_tmp.errorString());
+		return false;
+	}
+
+	m_buf.reserve(BLOCKSIZE);
+	m_written = Q_INT64_C(0);
+	m_committed = m_failed = false;
+
+	return QIODevice::open(mode);
+}
+
+void FileSink::close() {
+
+	// without a commit the destination stays untouched
+	if(!m_committed && m_tmp.isOpen()) {
+		m_tmp.close();
+		m_tmp.remove();
+	}
+
+	m_buf.clear();
+
+	QIODevice::close();
+}
+
+bool FileSink::isSequential() const {
+	return true;
+}
+
+bool FileSink::reset() {
+
+	m_buf.clear();
+	m_written = Q_INT64_C(0);
+
+	return m_tmp.resize(0) && m_tmp.seek(0);
+}
+
+bool FileSink::preallocate(qint64 size) {
+#ifdef HAVE_POSIX_FALLOCATE
+	const int r = m_tmp.isOpen() && size > m_written ?
+				posix_fallocate(m_tmp.handle(), 0, static_cast<off_t>(size)) : 0;
+
+	// file systems not supporting it are no reason to fail, a full disk is
+	if(r == ENOSPC || r == EFBIG) return fail(QString("cannot allocate %1 bytes for %2").
+											  arg(size).arg(m_fileName));
+#else
+	Q_UNUSED(size)
+#endif
+
+	return true;
+}
+
+bool FileSink::commit() {
+
+	if(!isOpen() || m_committed) return m_committed;
+
+	if(!flushBuffer(true) || !m_tmp.flush()) return fail(m_tmp.errorString());
+
+	// drop what got preallocated but not received
+	if(m_tmp.size() != m_written && !m_tmp.resize(m_written)) return fail(m_tmp.errorString());
+
+	if(!syncFile(m_tmp.handle())) return fail(QString("cannot sync %1").arg(m_tmp.fileName()));
+
+	const QFileInfo dest(m_fileName);
+
+	m_tmp.setPermissions(dest.exists() ? dest.permissions() :
+										 QFile::ReadOwner|QFile::WriteOwner|QFile::ReadUser|
+										 QFile::WriteUser|QFile::ReadGroup|QFile::ReadOther);
+
+	const QString tmpName(m_tmp.fileName());
+
+	m_tmp.close();
+
+#if defined(Q_OS_WIN)
+	const bool renamed = MoveFileExW(reinterpret_cast<const wchar_t *>(
+										 QDir::toNativeSeparators(tmpName).utf16()),
+									 reinterpret_cast<const wchar_t *>(
+										 QDir::toNativeSeparators(m_fileName).utf16()),
+									 MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH);
+#else
+	const bool renamed = !::rename(QFile::encodeName(tmpName).constData(),
+								   QFile::encodeName(m_fileName).constData());
+#endif
+
+	if(!renamed) {
+		m_tmp.remove();
+		return fail(QString("cannot replace %1").arg(m_fileName));
+	}
+
+	m_tmp.setAutoRemove(false);
+
+#ifdef Q_OS_UNIX
+	// persist the directory entry as well
+	const int dir = ::open(QFile::encodeName(dest.absolutePath()).constData(), O_RDONLY);
+
+	if(dir != -1) {
+		syncFile(dir);
+		::close(dir);
+	}
+#endif
+
+	m_committed = true;
+
+	QIODevice::close();
+
+	return true;
+}
+
+qint64 FileSink::readData(char *, qint64) {
+	return Q_INT64_C(-1);
+}
+
+qint64 FileSink::writeData(const char *data, qint64 len) {
+
+	m_buf.append(data, static_cast<int>(len));
+
+	return m_buf.size() < BLOCKSIZE || flushBuffer(false) ? len : Q_INT64_C(-1);
+}
+
+bool FileSink::flushBuffer(bool all) {
+
+	// whole blocks only, thus every write starts at an aligned offset
+	const int n = all ? m_buf.size() : m_buf.size() - m_buf.size() % BLOCKSIZE;
+
+	if(!n) return true;
+
+	if(m_tmp.write(m_buf.constData(), n) != n) return fail(m_tmp.errorString());
+
+	m_buf.remove(0, n);
+	m_written += n;
+
+	return true;
+}
+
+bool FileSink::fail(const QString &err) {
+	setErrorString(err);
+	m_failed = true;
+	return false;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILESINK_H
+#define FILESINK_H
+
+#include <QTemporaryFile>
+
+/**
+ * Crash-safe output device for file downloads
+ *
+ * The data is written to a temporary file next to the destination, in large
+ * block aligned writes, into space preallocated from the @em Content-Length
+ * if known. Only @c commit flushes it to the disk and atomically replaces the
+ * destination, thus the destination is either complete or untouched.
+ */
+class Q_DECL_HIDDEN FileSink : public QIODevice {
+	Q_OBJECT
+	Q_DISABLE_COPY(FileSink)
+public:
+	explicit FileSink(const QString &fileName);
+	virtual ~FileSink();
+
+	virtual bool open(OpenMode mode);
+	virtual void close();
+	virtual bool isSequential() const;
+	virtual bool reset();
+
+	bool preallocate(qint64 size);
+	bool commit();
+
+	inline bool hasFailed() const {
+		return m_failed;
+	}
+
+protected:
+	virtual qint64 readData(char *data, qint64 maxSize);
+	virtual qint64 writeData(const char *data, qint64 len);
+
+private:
+	bool flushBuffer(bool all);
+	bool fail(const QString &err);
+
+private:
+	const QString m_fileName;
+	QTemporaryFile m_tmp;
+	QByteArray m_buf;
+	qint64 m_written;
+	bool m_committed;
+	bool m_failed;
+};
+
+#endif // FILESINK_H
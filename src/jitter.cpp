@@ -0,0 +1,71 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtGlobal>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#else
+#include <QMutex>
+#include <QDateTime>
+#include <QCoreApplication>
+#endif
+
+#include "jitter.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
+namespace {
+
+struct State {
+
+	State() : mutex(), x(static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()) ^
+						 (static_cast<quint64>(QCoreApplication::applicationPid()) << 32) ^
+						 static_cast<quint64>(reinterpret_cast<quintptr>(this))) {
+		if(!x) x = Q_UINT64_C(0x9E3779B97F4A7C15);
+	}
+
+	QMutex mutex;
+	quint64 x;
+};
+
+}
+
+Q_GLOBAL_STATIC(State, state)
+#endif
+
+qint64 Jitter::bounded(qint64 n) {
+
+	if(n <= Q_INT64_C(0)) return Q_INT64_C(0);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	return static_cast<qint64>(QRandomGenerator::global()->generate64() %
+							   static_cast<quint64>(n));
+#else
+	QMutexLocker lock(&state()->mutex);
+
+	quint64 &x(state()->x);
+
+	// xorshift64*
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+
+	return static_cast<qint64>((x * Q_UINT64_C(2685821657736338717)) % static_cast<quint64>(n));
+#endif
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JITTER_H
+#define JITTER_H
+
+#include <QtGlobal>
+
+/**
+ * Random numbers for retry backoff and polling jitter
+ *
+ * The generator is private to the library and seeded once per process, so
+ * neither does it touch the @c qrand() sequence of the application, nor do
+ * processes started alike draw the same numbers.
+ */
+class Q_DECL_HIDDEN Jitter {
+	Q_DISABLE_COPY(Jitter)
+public:
+	/// a random number in [0, @c n), @c 0 if @c n is not positive
+	static qint64 bounded(qint64 n);
+
+private:
+	Jitter();
+};
+
+#endif // JITTER_H
@@ -0,0 +1,279 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jsonindex.h"
+#include "apiworker.h"
+#include "jsonparser.h"
+
+namespace {
+
+inline bool isDelimiter(char c) {
+
+	switch(c) {
+	case ',': case '}': case ']': case ' ': case '\n': case '\r': case '\t':
+		return true;
+	default:
+		return false;
+	}
+}
+
+}
+
+JsonIndex::JsonIndex(const QByteArray &json) : m_json(json), m_entries(), m_array(false),
+	m_valid(false), m_mutex(), m_members(), m_variant() {
+
+	int pos = skipSpace(0);
+
+	if(pos >= m_json.size()) return;
+
+	if(m_json[pos] == '{') {
+
+		const int end = skipValue(pos);
+
+		if(end != -1) m_entries.append(SPAN(pos, end));
+
+		m_valid = end != -1 && skipSpace(end) == m_json.size();
+
+	} else if(m_json[pos] == '[') {
+
+		m_array = true;
+
+		if((pos = skipSpace(pos + 1)) < m_json.size() && m_json[pos] == ']') {
+			m_valid = skipSpace(pos + 1) == m_json.size();
+			return;
+		}
+
+		while(pos < m_json.size()) {
+
+			const int end = skipValue(pos);
+
+			if(end == -1 || m_json[pos] != '{') return;
+
+			m_entries.append(SPAN(pos, end));
+
+			if((pos = skipSpace(end)) >= m_json.size()) return;
+
+			if(m_json[pos] == ']') {
+				m_valid = skipSpace(pos + 1) == m_json.size();
+				return;
+			}
+
+			if(m_json[pos] != ',') return;
+
+			pos = skipSpace(pos + 1);
+		}
+	}
+}
+
+int JsonIndex::skipSpace(int pos) const {
+
+	while(pos < m_json.size()) {
+
+		const char c = m_json[pos];
+
+		if(c != ' ' && c != '\n' && c != '\r' && c != '\t') break;
+
+		++pos;
+	}
+
+	return pos;
+}
+
+int JsonIndex::skipString(int pos) const {
+
+	const char *d = m_json.constData();
+	const char *const end = d + m_json.size();
+
+	for(const char *p = d + pos + 1; (p = JsonParser::findSpecial(p, end)) < end; p += 2) {
+		if(*p == '"') return static_cast<int>(p - d) + 1;
+	}
+
+	return -1;
+}
+
+int JsonIndex::skipValue(int pos) const {
+
+	if(pos >= m_json.size()) return -1;
+
+	const char *d = m_json.constData();
+
+	if(d[pos] == '"') return skipString(pos);
+
+	if(d[pos] == '{' || d[pos] == '[') {
+
+		QByteArray open;
+
+		while(pos < m_json.size()) {
+
+			switch(d[pos]) {
+			case '"':
+				if((pos = skipString(pos)) == -1) return -1;
+				continue;
+			case '{':
+			case '[':
+				open.append(d[pos]);
+				break;
+			case '}':
+			case ']':
+				if(open.isEmpty() || open[open.size() - 1] != (d[pos] == '}' ? '{' : '[')) {
+					return -1;
+				}
+
+				open.chop(1);
+
+				if(open.isEmpty()) return pos + 1;
+
+				break;
+			default:
+				break;
+			}
+
+			++pos;
+		}
+
+		return -1;
+	}
+
+	const int start = pos;
+
+	while(pos < m_json.size() && !isDelimiter(d[pos])) ++pos;
+
+	return pos > start ? pos : -1;
+}
+
+const JsonIndex::MEMBERS &JsonIndex::members(int pos) const {
+
+	QHash<int, MEMBERS>::const_iterator i(m_members.constFind(pos));
+
+	if(i != m_members.constEnd()) return *i;
+
+	MEMBERS &m(m_members[pos]);
+
+	if(pos < 0 || pos >= m_json.size() || m_json[pos] != '{') return m;
+
+	pos = skipSpace(pos + 1);
+
+	while(pos < m_json.size() && m_json[pos] == '"') {
+
+		const int keyEnd = skipString(pos);
+
+		if(keyEnd == -1) break;
+
+		const QByteArray raw(m_json.mid(pos + 1, keyEnd - pos - 2));
+		const QByteArray key(raw.contains('\\') ? decodeString(pos, keyEnd).toUtf8() : raw);
+
+		if((pos = skipSpace(keyEnd)) >= m_json.size() || m_json[pos] != ':') break;
+
+		const int start = skipSpace(pos + 1);
+		const int end = skipValue(start);
+
+		if(end == -1) break;
+
+		m.insert(key, SPAN(start, end));
+
+		if((pos = skipSpace(end)) >= m_json.size() || m_json[pos] != ',') break;
+
+		pos = skipSpace(pos + 1);
+	}
+
+	return m;
+}
+
+QVariant JsonIndex::value(int idx, const QString &id, const QString &subId) const {
+
+	if(idx < 0 || idx >= m_entries.count()) return QVariant();
+
+	QMutexLocker lock(&m_mutex);
+
+	SPAN span(-1, -1);
+	const MEMBERS &m(members(m_entries[idx].first));
+
+	if(subId.isEmpty()) {
+		span = m.value(id.toUtf8(), span);
+	} else {
+
+		const SPAN sub(m.value(subId.toUtf8(), span));
+
+		if(sub.first != -1) span = members(sub.first).value(id.toUtf8(), span);
+	}
+
+	return span.first != -1 ? decode(span) : QVariant();
+}
+
+QVariant JsonIndex::toVariant() const {
+
+	QMutexLocker lock(&m_mutex);
+
+	if(!m_variant.isValid()) {
+		QString err;
+		m_variant = ApiWorker::parseJSon(m_json, err);
+	}
+
+	return m_variant;
+}
+
+QVariant JsonIndex::decode(const SPAN &span) const {
+
+	const QByteArray tok(QByteArray::fromRawData(m_json.constData() + span.first,
+												 span.second - span.first));
+
+	switch(tok[0]) {
+	case '"':
+		return decodeString(span.first, span.second);
+	case '{':
+	case '[': {
+		QString err;
+		return ApiWorker::parseJSon(QByteArray(tok.constData(), tok.size()), err);
+	}
+	case 't':
+		return QVariant(true);
+	case 'f':
+		return QVariant(false);
+	case 'n':
+		return QVariant();
+	default:
+		break;
+	}
+
+	bool ok = false;
+
+	if(!(tok.contains('.') || tok.contains('e') || tok.contains('E'))) {
+
+		const qlonglong ll = tok.toLongLong(&ok);
+
+		if(ok) return QVariant(ll);
+
+		const qulonglong ull = tok.toULongLong(&ok);
+
+		if(ok) return QVariant(ull);
+	}
+
+	const double d = tok.toDouble(&ok);
+
+	return ok ? QVariant(d) : QVariant();
+}
+
+QString JsonIndex::decodeString(int pos, int end) const {
+
+	QString s;
+
+	JsonParser::string(m_json.constData() + pos, m_json.constData() + end, s);
+
+	return s;
+}
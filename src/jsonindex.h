@@ -0,0 +1,78 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSONINDEX_H
+#define JSONINDEX_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVariant>
+#include <QSharedPointer>
+
+/**
+ * Structural index over raw JSon release information
+ *
+ * Building the index only locates the entries of the top-level array, the
+ * members of an entry get located on its first access and only the values
+ * actually requested get decoded. The raw data is kept implicitly shared.
+ */
+class Q_DECL_HIDDEN JsonIndex {
+	Q_DISABLE_COPY(JsonIndex)
+public:
+	explicit JsonIndex(const QByteArray &json);
+
+	inline bool isValid() const {
+		return m_valid;
+	}
+
+	inline bool isArray() const {
+		return m_array;
+	}
+
+	inline int entries() const {
+		return m_entries.count();
+	}
+
+	QVariant value(int idx, const QString &id, const QString &subId = QString::null) const;
+	QVariant toVariant() const;
+
+private:
+	typedef QPair<int, int> SPAN;
+	typedef QHash<QByteArray, SPAN> MEMBERS;
+
+	int skipSpace(int pos) const;
+	int skipString(int pos) const;
+	int skipValue(int pos) const;
+	const MEMBERS &members(int pos) const;
+	QVariant decode(const SPAN &span) const;
+	QString decodeString(int pos, int end) const;
+
+private:
+	const QByteArray m_json;
+	QList<SPAN> m_entries;
+	bool m_array;
+	bool m_valid;
+	mutable QMutex m_mutex;
+	mutable QHash<int, MEMBERS> m_members;
+	mutable QVariant m_variant;
+};
+
+Q_DECLARE_METATYPE(QSharedPointer<JsonIndex>)
+
+#endif // JSONINDEX_H
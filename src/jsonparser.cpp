@@ -0,0 +1,461 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define JSONPARSER_SSE2
+#include <emmintrin.h>
+#if defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define JSONPARSER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#include "jsonparser.h"
+
+namespace {
+
+const int MAXDEPTH = 512;
+
+const char *findScalar(const char *p, const char *end) {
+
+	while(p < end && *p != '"' && *p != '\\') ++p;
+
+	return p;
+}
+
+#ifdef JSONPARSER_SSE2
+const char *findSse2(const char *p, const char *end) {
+
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i escape = _mm_set1_epi8('\\');
+
+	for(; end - p >= 16; p += 16) {
+
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const int m = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(c, quote),
+													 _mm_cmpeq_epi8(c, escape)));
+
+		if(m) return p + __builtin_ctz(static_cast<unsigned int>(m));
+	}
+
+	return findScalar(p, end);
+}
+#endif
+
+#ifdef JSONPARSER_AVX2
+__attribute__((target("avx2")))
+const char *findAvx2(const char *p, const char *end) {
+
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i escape = _mm256_set1_epi8('\\');
+
+	for(; end - p >= 32; p += 32) {
+
+		const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		const int m = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(c, quote),
+														   _mm256_cmpeq_epi8(c, escape)));
+
+		if(m) return p + __builtin_ctz(static_cast<unsigned int>(m));
+	}
+
+	return findSse2(p, end);
+}
+#endif
+
+void appendUtf8(QByteArray &utf8, uint cp) {
+
+	if(cp < 0x80) {
+		utf8.append(static_cast<char>(cp));
+	} else if(cp < 0x800) {
+		utf8.append(static_cast<char>(0xC0 | (cp >> 6)));
+		utf8.append(static_cast<char>(0x80 | (cp & 0x3F)));
+	} else if(cp < 0x10000) {
+		utf8.append(static_cast<char>(0xE0 | (cp >> 12)));
+		utf8.append(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+		utf8.append(static_cast<char>(0x80 | (cp & 0x3F)));
+	} else {
+		utf8.append(static_cast<char>(0xF0 | (cp >> 18)));
+		utf8.append(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+		utf8.append(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+		utf8.append(static_cast<char>(0x80 | (cp & 0x3F)));
+	}
+}
+
+bool hex4(const char *p, const char *end, uint &cp) {
+
+	if(end - p < 4) return false;
+
+	bool ok = false;
+
+	cp = QByteArray::fromRawData(p, 4).toUInt(&ok, 16);
+
+	return ok;
+}
+
+}
+
+JsonParser::ISA JsonParser::detectedIsa() {
+
+#ifdef JSONPARSER_AVX2
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("avx2")) return AVX2;
+#endif
+
+#ifdef JSONPARSER_SSE2
+	return SSE2;
+#else
+	return SCALAR;
+#endif
+}
+
+namespace {
+
+typedef const char *(*FINDFUNC)(const char *, const char *);
+
+/// the scanner in use, set up once with the best one the CPU supports
+struct Dispatch {
+
+	Dispatch() : isa(JsonParser::SCALAR), find(findScalar) {
+		select(JsonParser::AVX2);
+	}
+
+	void select(JsonParser::ISA i) {
+
+		isa = qMin(i, JsonParser::detectedIsa());
+
+		switch(isa) {
+#ifdef JSONPARSER_AVX2
+		case JsonParser::AVX2: find = findAvx2; break;
+#endif
+#ifdef JSONPARSER_SSE2
+		case JsonParser::SSE2: find = findSse2; break;
+#endif
+		default: find = findScalar; break;
+		}
+	}
+
+	JsonParser::ISA isa;
+	FINDFUNC find;
+};
+
+}
+
+Q_GLOBAL_STATIC(Dispatch, dispatch)
+
+JsonParser::JsonParser(const QByteArray &json) : m_json(json), m_pos(m_json.constData()),
+	m_end(m_json.constData() + m_json.size()), m_error() {}
+
+JsonParser::ISA JsonParser::isa() {
+	return dispatch()->isa;
+}
+
+void JsonParser::setIsa(ISA isa) {
+	dispatch()->select(isa);
+}
+
+const char *JsonParser::findSpecial(const char *p, const char *end) {
+	return dispatch()->find(p, end);
+}
+
+const char *JsonParser::string(const char *p, const char *end, QString &s) {
+
+	const char *q = findSpecial(++p, end);
+
+	if(q == end) return 0L;
+
+	// the common case, nothing to unescape
+	if(*q == '"') {
+		s = QString::fromUtf8(p, static_cast<int>(q - p));
+		return q + 1;
+	}
+
+	QByteArray utf8;
+
+	for(;;) {
+
+		utf8.append(p, static_cast<int>(q - p));
+
+		if(q == end) return 0L;
+
+		if(*q == '"') break;
+
+		if(++q == end) return 0L;
+
+		switch(*q) {
+		case 'b': utf8.append('\b'); break;
+		case 'f': utf8.append('\f'); break;
+		case 'n': utf8.append('\n'); break;
+		case 'r': utf8.append('\r'); break;
+		case 't': utf8.append('\t'); break;
+		case '"': case '\\': case '/': utf8.append(*q); break;
+		case 'u': {
+
+			uint cp;
+
+			if(!hex4(q + 1, end, cp)) return 0L;
+
+			q += 4;
+
+			if(cp >= 0xD800 && cp < 0xDC00 && end - q > 6 && q[1] == '\\' && q[2] == 'u') {
+
+				uint lo;
+
+				if(hex4(q + 3, end, lo) && lo >= 0xDC00 && lo < 0xE000) {
+					cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+					q += 6;
+				}
+			}
+
+			appendUtf8(utf8, cp);
+			break;
+		}
+		default:
+			return 0L;
+		}
+
+		q = findSpecial(p = q + 1, end);
+	}
+
+	s = QString::fromUtf8(utf8.constData(), utf8.size());
+
+	return q + 1;
+}
+
+QVariant JsonParser::parse(QString &err) {
+
+	QVariant v;
+
+	m_pos = m_json.constData();
+	m_error = QString::null;
+
+	skipSpace();
+
+	if(value(v, 0)) {
+
+		skipSpace();
+
+		if(m_pos != m_end) fail("garbage after document");
+	}
+
+	err = m_error;
+
+	return m_error.isNull() ? v : QVariant();
+}
+
+void JsonParser::skipSpace() {
+	while(m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+		++m_pos;
+	}
+}
+
+bool JsonParser::fail(const char *what) {
+
+	if(m_error.isNull()) {
+		m_error = QString("%1 at offset %2").arg(what).
+				arg(static_cast<qint64>(m_pos - m_json.constData()));
+	}
+
+	return false;
+}
+
+bool JsonParser::literal(const char *lit, int len) {
+
+	if(m_end - m_pos < len || qstrncmp(m_pos, lit, static_cast<uint>(len))) {
+		return fail("invalid literal");
+	}
+
+	m_pos += len;
+
+	return true;
+}
+
+bool JsonParser::value(QVariant &v, int depth) {
+
+	if(m_pos == m_end) return fail("unexpected end");
+
+	switch(*m_pos) {
+	case '{': return object(v, depth + 1);
+	case '[': return array(v, depth + 1);
+	case '"': {
+
+		QString s;
+		const char *p = string(m_pos, m_end, s);
+
+		if(!p) return fail("invalid string");
+
+		m_pos = p;
+		v = s;
+		return true;
+	}
+	case 't':
+		v = true;
+		return literal("true", 4);
+	case 'f':
+		v = false;
+		return literal("false", 5);
+	case 'n':
+		v = QVariant();
+		return literal("null", 4);
+	default:
+		return number(v);
+	}
+}
+
+bool JsonParser::object(QVariant &v, int depth) {
+
+	if(depth > MAXDEPTH) return fail("nesting too deep");
+
+	QVariantMap map;
+
+	++m_pos;
+	skipSpace();
+
+	if(m_pos < m_end && *m_pos == '}') {
+		++m_pos;
+		v = map;
+		return true;
+	}
+
+	while(m_pos < m_end) {
+
+		QString key;
+
+		if(*m_pos != '"') return fail("expected a key");
+
+		const char *p = string(m_pos, m_end, key);
+
+		if(!p) return fail("invalid key");
+
+		m_pos = p;
+		skipSpace();
+
+		if(m_pos == m_end || *m_pos != ':') return fail("expected ':'");
+
+		++m_pos;
+		skipSpace();
+
+		if(!value(map[key], depth)) return false;
+
+		skipSpace();
+
+		if(m_pos < m_end && *m_pos == '}') {
+			++m_pos;
+			v = map;
+			return true;
+		}
+
+		if(m_pos == m_end || *m_pos != ',') return fail("expected ',' or '}'");
+
+		++m_pos;
+		skipSpace();
+	}
+
+	return fail("unexpected end");
+}
+
+bool JsonParser::array(QVariant &v, int depth) {
+
+	if(depth > MAXDEPTH) return fail("nesting too deep");
+
+	QVariantList list;
+
+	++m_pos;
+	skipSpace();
+
+	if(m_pos < m_end && *m_pos == ']') {
+		++m_pos;
+		v = list;
+		return true;
+	}
+
+	while(m_pos < m_end) {
+
+		list.append(QVariant());
+
+		if(!value(list.last(), depth)) return false;
+
+		skipSpace();
+
+		if(m_pos < m_end && *m_pos == ']') {
+			++m_pos;
+			v = list;
+			return true;
+		}
+
+		if(m_pos == m_end || *m_pos != ',') return fail("expected ',' or ']'");
+
+		++m_pos;
+		skipSpace();
+	}
+
+	return fail("unexpected end");
+}
+
+bool JsonParser::number(QVariant &v) {
+
+	const char *p = m_pos;
+	bool integer = true;
+
+	if(p < m_end && *p == '-') ++p;
+
+	for(; p < m_end; ++p) {
+
+		const char c = *p;
+
+		if(c >= '0' && c <= '9') continue;
+
+		if(c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+			integer = false;
+			continue;
+		}
+
+		break;
+	}
+
+	const QByteArray tok(QByteArray::fromRawData(m_pos, static_cast<int>(p - m_pos)));
+	bool ok = false;
+
+	if(integer) {
+
+		const qlonglong ll = tok.toLongLong(&ok);
+
+		if(ok) {
+			v = ll;
+		} else {
+
+			const qulonglong ull = tok.toULongLong(&ok);
+
+			if(ok) v = ull;
+		}
+	}
+
+	if(!ok) {
+
+		const double d = tok.toDouble(&ok);
+
+		if(!ok) return fail("invalid number");
+
+		v = d;
+	}
+
+	m_pos = p;
+
+	return true;
+}
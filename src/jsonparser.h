@@ -0,0 +1,70 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSONPARSER_H
+#define JSONPARSER_H
+
+#include <QVariant>
+
+/**
+ * Built-in JSon parser
+ *
+ * Strings, which make up most of the release information, are scanned for
+ * their end with SSE2 or AVX2 if the CPU supports it, unescaped strings are
+ * converted without any intermediate copy.
+ */
+class Q_DECL_HIDDEN JsonParser {
+	Q_DISABLE_COPY(JsonParser)
+public:
+	typedef enum { SCALAR, SSE2, AVX2 } ISA;
+
+	explicit JsonParser(const QByteArray &json);
+
+	QVariant parse(QString &err);
+
+	static ISA isa();
+	static ISA detectedIsa();
+
+	/**
+	 * Restricts the string scanner to @c isa, or less if the CPU lacks it
+	 *
+	 * @note not synchronised with parsing, select the ISA before any parsing
+	 */
+	static void setIsa(ISA isa);
+
+	static const char *findSpecial(const char *p, const char *end);
+	static const char *string(const char *p, const char *end, QString &s);
+
+private:
+	bool value(QVariant &v, int depth);
+	bool object(QVariant &v, int depth);
+	bool array(QVariant &v, int depth);
+	bool number(QVariant &v);
+	bool literal(const char *lit, int len);
+	bool fail(const char *what);
+	void skipSpace();
+
+private:
+	const QByteArray m_json;
+	const char *m_pos;
+	const char *const m_end;
+	QString m_error;
+};
+
+#endif // JSONPARSER_H
@@ -18,6 +18,7 @@
  */
 
 #include "qgithubreleaseapi_p.h"
+#include "bandwidthlimiter.h"
 
 QGitHubReleaseAPI::QGitHubReleaseAPI(const QUrl &apiUrl, bool multi, QObject *p) : QObject(p),
 	d_ptr(new QGitHubReleaseAPIPrivate(apiUrl, multi, RAW, this)) {
@@ -77,12 +78,24 @@ QGitHubReleaseAPI::QGitHubReleaseAPI(const QString &user, const QString &repo, i
 	init();
 }
 
+QGitHubReleaseAPI::QGitHubReleaseAPI(QFile &snapshot, QObject *p) : QObject(p),
+	d_ptr(new QGitHubReleaseAPIPrivate(snapshot, this)) {
+	init();
+}
+
 QGitHubReleaseAPI::~QGitHubReleaseAPI() {}
 
 void QGitHubReleaseAPI::init() const {
 	Q_D(const QGitHubReleaseAPI);
+	qRegisterMetaType<QGitHubReleaseSnapshot>("QGitHubReleaseSnapshot");
 	QObject::connect(d, SIGNAL(canceled()), this, SLOT(apiCanceled()));
 	QObject::connect(d, SIGNAL(available()), this, SLOT(apiAvailable()));
+	QObject::connect(d, SIGNAL(notModified()), this, SLOT(apiNotModified()));
+	QObject::connect(d, SIGNAL(bodyAvailable(int,QString)),
+					 this, SLOT(apiBodyAvailable(int,QString)));
+	QObject::connect(d, SIGNAL(avatarAvailable(int,QImage)),
+					 this, SLOT(apiAvatarAvailable(int,QImage)));
+	QObject::connect(d, SIGNAL(bodiesRendered()), this, SLOT(apiBodiesRendered()));
 	QObject::connect(d, SIGNAL(error(QString)), this, SLOT(apiError(QString)));
 	QObject::connect(d, SIGNAL(progress(qint64,qint64)),
 					 this, SLOT(apiDownloadProgress(qint64,qint64)));
@@ -92,10 +105,85 @@ void QGitHubReleaseAPI::setUserAgent(const char *ua) {
 	QGitHubReleaseAPIPrivate::setUserAgent(ua);
 }
 
+void QGitHubReleaseAPI::setWorkerThreadEnabled(bool b) {
+	QGitHubReleaseAPIPrivate::setWorkerThreadEnabled(b);
+}
+
+void QGitHubReleaseAPI::setLazyParsingEnabled(bool b) {
+	QGitHubReleaseAPIPrivate::setLazyParsingEnabled(b);
+}
+
+void QGitHubReleaseAPI::setApiBaseUrl(const QUrl &url) {
+	QGitHubReleaseAPIPrivate::setApiBaseUrl(url);
+}
+
+QUrl QGitHubReleaseAPI::apiBaseUrl() {
+	return QGitHubReleaseAPIPrivate::apiBaseUrl();
+}
+
+QUrl QGitHubReleaseAPI::releasesApiUrl(const QString &user, const QString &repo, int perPage,
+									   const QUrl &baseUrl) {
+	return QGitHubReleaseAPIPrivate::releasesApiUrl(user, repo, perPage, baseUrl);
+}
+
+QUrl QGitHubReleaseAPI::latestReleaseApiUrl(const QString &user, const QString &repo,
+											const QUrl &baseUrl) {
+	return QGitHubReleaseAPIPrivate::latestReleaseApiUrl(user, repo, baseUrl);
+}
+
+QUrl QGitHubReleaseAPI::tagReleaseApiUrl(const QString &user, const QString &repo,
+										 const QString &tag, const QUrl &baseUrl) {
+	return QGitHubReleaseAPIPrivate::tagReleaseApiUrl(user, repo, tag, baseUrl);
+}
+
+void QGitHubReleaseAPI::setUrlRewriter(URLREWRITER rewriter, void *userData) {
+	FileDownloader::setUrlRewriter(rewriter, userData);
+}
+
+void QGitHubReleaseAPI::setRetryPolicy(int maxAttempts, int baseDelay, int maxDelay) {
+	FileDownloader::setRetryPolicy(maxAttempts, baseDelay, maxDelay);
+}
+
+void QGitHubReleaseAPI::setHedging(int percentile, int minSamples) {
+	FileDownloader::setHedging(percentile, minSamples);
+}
+
+void QGitHubReleaseAPI::setTimeouts(int connectTimeout, int idleTimeout, int totalTimeout) {
+	FileDownloader::setTimeouts(connectTimeout, idleTimeout, totalTimeout);
+}
+
+void QGitHubReleaseAPI::setMinThroughput(int bytesPerSecond, int window) {
+	FileDownloader::setMinThroughput(bytesPerSecond, window);
+}
+
+void QGitHubReleaseAPI::setHttp2Enabled(bool b) {
+	FileDownloader::setHttp2Enabled(b);
+}
+
+void QGitHubReleaseAPI::setBandwidthLimit(int bytesPerSecond, int perTransferBytesPerSecond) {
+	BandwidthLimiter::setLimits(bytesPerSecond, perTransferBytesPerSecond);
+}
+
 void QGitHubReleaseAPI::apiAvailable() {
 	emit available(*this);
 }
 
+void QGitHubReleaseAPI::apiNotModified() {
+	emit notModified();
+}
+
+void QGitHubReleaseAPI::apiBodyAvailable(int idx, const QString &b) {
+	emit bodyAvailable(idx, b);
+}
+
+void QGitHubReleaseAPI::apiAvatarAvailable(int idx, const QImage &img) {
+	emit avatarAvailable(idx, img);
+}
+
+void QGitHubReleaseAPI::apiBodiesRendered() {
+	emit bodiesRendered();
+}
+
 void QGitHubReleaseAPI::apiCanceled() {
 	emit canceled();
 }
@@ -182,11 +270,57 @@ QVariantList QGitHubReleaseAPI::toVariantList() const {
 	return d->toVariantList();
 }
 
+QGitHubReleaseSnapshot QGitHubReleaseAPI::snapshot() const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->snapshot();
+}
+
 QByteArray QGitHubReleaseAPI::asJsonData() const {
 	Q_D(const QGitHubReleaseAPI);
 	return d->asJsonData();
 }
 
+bool QGitHubReleaseAPI::saveSnapshot(QFile &of) const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->saveSnapshot(of);
+}
+
+bool QGitHubReleaseAPI::saveIndex(QFile &of) const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->saveIndex(of);
+}
+
+int QGitHubReleaseAPI::indexOfTag(const QString &tag) const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->indexOfTag(tag);
+}
+
+int QGitHubReleaseAPI::indexOfId(ulong id) const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->indexOfId(id);
+}
+
+QList<int> QGitHubReleaseAPI::releasesBetween(const QDateTime &from, const QDateTime &to) const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->releasesBetween(from, to);
+}
+
+int QGitHubReleaseAPI::indexOfNewestRelease() const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->indexOfNewestRelease();
+}
+
+QList<int> QGitHubReleaseAPI::sortedByVersion() const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->sortedByVersion();
+}
+
+QList<int> QGitHubReleaseAPI::newerThan(const QString &version, bool preReleases,
+										bool drafts) const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->newerThan(version, preReleases, drafts);
+}
+
 uint QGitHubReleaseAPI::rateLimit() const {
 	Q_D(const QGitHubReleaseAPI);
 	return d->rateLimit();
@@ -237,6 +371,18 @@ qint64 QGitHubReleaseAPI::zipBall(QFile &of, int idx) const {
 	return d->zipBall(of, idx);
 }
 
+qint64 QGitHubReleaseAPI::extractTarBall(const QString &dir, const QStringList &filters,
+										 int idx) const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->extractTarBall(dir, filters, idx);
+}
+
+qint64 QGitHubReleaseAPI::extractZipBall(const QString &dir, const QStringList &filters,
+										 int idx) const {
+	Q_D(const QGitHubReleaseAPI);
+	return d->extractZipBall(dir, filters, idx);
+}
+
 QString QGitHubReleaseAPI::targetCommitish(int idx) const {
 	Q_D(const QGitHubReleaseAPI);
 	return d->targetCommitish(idx);
@@ -277,6 +423,26 @@ void QGitHubReleaseAPI::cancel() {
 	return d->cancel();
 }
 
+void QGitHubReleaseAPI::refresh() {
+	Q_D(QGitHubReleaseAPI);
+	d->refresh();
+}
+
+void QGitHubReleaseAPI::requestBody(int idx) {
+	Q_D(QGitHubReleaseAPI);
+	d->requestBody(idx);
+}
+
+void QGitHubReleaseAPI::requestAvatar(int idx) {
+	Q_D(QGitHubReleaseAPI);
+	d->requestAvatar(idx);
+}
+
+void QGitHubReleaseAPI::renderAllBodies() {
+	Q_D(QGitHubReleaseAPI);
+	d->renderAllBodies();
+}
+
 QByteArray QGitHubReleaseAPI::downloadToMemory(const QUrl &url) const {
 	Q_D(const QGitHubReleaseAPI);
 	return d->downloadFile(url);
@@ -284,5 +450,5 @@ QByteArray QGitHubReleaseAPI::downloadToMemory(const QUrl &url) const {
 
 qint64 QGitHubReleaseAPI::downloadToFile(const QUrl &url, QFile &of) const {
 	Q_D(const QGitHubReleaseAPI);
-	return d->downloadFile(url, &of);
+	return d->downloadFile(url, of);
 }
@@ -27,11 +27,14 @@
 #include <QUrl>
 #include <QImage>
 #include <QDateTime>
+#include <QStringList>
 #include <QVariantList>
 
 QT_FORWARD_DECLARE_CLASS(QFile)
 QT_FORWARD_DECLARE_CLASS(QGitHubReleaseAPIPrivate)
 
+class QGitHubReleaseSnapshot;
+
 #ifndef Q_DECL_EXPORT
 #define Q_DECL_EXPORT __attribute__((visibility ("default")))
 #endif
@@ -85,6 +88,11 @@ public:
 				   HTML ///< receive a html body (rendered by GitHub)
 				 } TYPE;
 
+	/**
+	 * @brief Callback rewriting the URLs requested
+	 */
+	typedef QUrl (*URLREWRITER)(const QUrl &url, void *userData);
+
 	/**
 	 * @brief Creates an @c %QGitHubReleaseAPI instance
 	 * @param apiUrl direct URL to retrieve
@@ -176,6 +184,22 @@ public:
 	QGitHubReleaseAPI(const QString &user, const QString &repo, int perPage,
 					  QObject *parent = 0);
 
+	/**
+	 * @brief Creates an @c %QGitHubReleaseAPI instance from a snapshot or an index
+	 *
+	 * No network access is performed. The @c available signal gets emitted as soon as
+	 * control returns to the event loop, or @c error if the snapshot could not get loaded.
+	 *
+	 * An index stays memory-mapped for the lifetime of the instance and the release
+	 * information is read from it on access.
+	 *
+	 * @param snapshot a snapshot written by @c saveSnapshot or an index written by
+	 * @c saveIndex
+	 * @see saveSnapshot
+	 * @see saveIndex
+	 */
+	explicit QGitHubReleaseAPI(QFile &snapshot, QObject *parent = 0);
+
 	virtual ~QGitHubReleaseAPI();
 
 	/**
@@ -185,6 +209,211 @@ public:
 	 */
 	static void setUserAgent(const char *userAgent);
 
+	/**
+	 * @brief Enables the worker thread mode
+	 *
+	 * If enabled, instances created afterwards retrieve and parse the release
+	 * information in a worker thread shared by all instances. The results are
+	 * delivered by queued signals, thus the calling thread never blocks on it.
+	 *
+	 * @note defaults to @c false
+	 * @note use @c requestBody and @c requestAvatar to also render bodies and
+	 * decode avatars off the calling thread
+	 *
+	 * @param enabled @c true to enable the worker thread mode, @c false otherwise
+	 */
+	static void setWorkerThreadEnabled(bool enabled);
+
+	/**
+	 * @brief Enables lazy parsing of the release information
+	 *
+	 * If enabled, instances receiving release information afterwards only
+	 * index its structure and decode the fields on first access. Checking a
+	 * few fields of a large page doesn't pay for decoding every body then.
+	 *
+	 * @note defaults to @c false
+	 * @note numbers are reported as @c qlonglong or @c double
+	 *
+	 * @param enabled @c true to enable lazy parsing, @c false otherwise
+	 */
+	static void setLazyParsingEnabled(bool enabled);
+
+	/**
+	 * @brief Sets the base URL of the API
+	 *
+	 * Instances created afterwards from an user and a repository, and the
+	 * emoji table, are requested below this URL instead of GitHub, e.g. from
+	 * a caching mirror like @em qgithubreleaseapi_mirror.
+	 *
+	 * @note defaults to @em https://api.github.com
+	 * @note an invalid URL restores the default
+	 *
+	 * @param url the base URL of the API
+	 */
+	static void setApiBaseUrl(const QUrl &url);
+
+	/**
+	 * @brief The base URL of the API
+	 * @return the base URL of the API
+	 */
+	static QUrl apiBaseUrl();
+
+	/**
+	 * @brief The URL of a release list
+	 *
+	 * Pass it to @c QGitHubReleaseAPI(const QUrl &, TYPE, bool, QObject *) to
+	 * request a single instance from another API, e.g. a GitHub Enterprise
+	 * instance, without changing the global base URL.
+	 *
+	 * @param user the user
+	 * @param repo the repository
+	 * @param perPage the number of releases
+	 * @param baseUrl the base URL of the API, the global one if invalid
+	 * @return the URL of the release list
+	 */
+	static QUrl releasesApiUrl(const QString &user, const QString &repo, int perPage = 30,
+							   const QUrl &baseUrl = QUrl());
+
+	/**
+	 * @brief The URL of the latest release
+	 * @note request it with @c multi set to @c false
+	 * @param user the user
+	 * @param repo the repository
+	 * @param baseUrl the base URL of the API, the global one if invalid
+	 * @return the URL of the latest release
+	 */
+	static QUrl latestReleaseApiUrl(const QString &user, const QString &repo,
+									const QUrl &baseUrl = QUrl());
+
+	/**
+	 * @brief The URL of a release by its tag
+	 * @note request it with @c multi set to @c false
+	 * @param user the user
+	 * @param repo the repository
+	 * @param tag the tag
+	 * @param baseUrl the base URL of the API, the global one if invalid
+	 * @return the URL of the release
+	 */
+	static QUrl tagReleaseApiUrl(const QString &user, const QString &repo, const QString &tag,
+								 const QUrl &baseUrl = QUrl());
+
+	/**
+	 * @brief Sets a callback rewriting every URL requested
+	 *
+	 * The callback gets the URLs of the release information, the emoji table,
+	 * avatars, images, assets, tarballs, zipballs and uploads, as well as the
+	 * targets of redirects, e.g. to @em codeload.github.com. It may return
+	 * them unchanged or point them to a mirror or a local test server.
+	 *
+	 * @note the callback is invoked in the thread of the request
+	 *
+	 * @param rewriter the callback or @c 0L to remove it
+	 * @param userData passed to the callback
+	 */
+	static void setUrlRewriter(URLREWRITER rewriter, void *userData = 0L);
+
+	/**
+	 * @brief Sets the retry policy for all requests
+	 *
+	 * Requests failing with a transient error (timeouts, connection resets,
+	 * @em 5xx and @em 429 responses) are retried after a randomized delay
+	 * between @c 0 and @c baseDelay * 2^(attempt - 1), capped by @c maxDelay.
+	 * A @em Retry-After header sent by the server is honoured.
+	 *
+	 * @note defaults to a single attempt, i.e. no retries
+	 *
+	 * @param maxAttempts the maximum number of attempts per request
+	 * @param baseDelay the base delay in milliseconds
+	 * @param maxDelay the maximum delay in milliseconds
+	 */
+	static void setRetryPolicy(int maxAttempts, int baseDelay = 500, int maxDelay = 30000);
+
+	/**
+	 * @brief Enables hedged requests
+	 *
+	 * If the release information or an image takes longer than the
+	 * @c percentile of the recent request times, a second identical request is
+	 * issued and the first response wins. Downloads to files are never hedged.
+	 *
+	 * @note defaults to @c 0, i.e. disabled
+	 *
+	 * @param percentile the percentile of the recent request times, @c 0 to disable
+	 * @param minSamples the number of request times needed before hedging starts
+	 */
+	static void setHedging(int percentile, int minSamples = 20);
+
+	/**
+	 * @brief Sets the timeouts for all requests
+	 *
+	 * A request exceeding a timeout is aborted and reported with an error
+	 * starting with @em Timeout. Connect and idle timeouts are retried
+	 * according to the retry policy, the total timeout is final.
+	 *
+	 * @note defaults to @c 30000, @c 60000 and @c 0
+	 *
+	 * @param connectTimeout the time in milliseconds to wait for the response headers
+	 * @param idleTimeout the time in milliseconds to wait for further data
+	 * @param totalTimeout the time in milliseconds a request may take including all
+	 * retries and redirects
+	 * @note a value of @c 0 disables the respective timeout
+	 * @see setRetryPolicy
+	 */
+	static void setTimeouts(int connectTimeout, int idleTimeout, int totalTimeout = 0);
+
+	/**
+	 * @brief Sets the minimum throughput for all requests
+	 *
+	 * A connection which degraded below @c bytesPerSecond, averaged over
+	 * @c window milliseconds, is canceled and restarted according to the
+	 * retry policy.
+	 *
+	 * @note defaults to @c 0, i.e. disabled
+	 * @note doesn't apply to tarballs, zipballs and file downloads, which
+	 * get throttled on purpose by setBandwidthLimit
+	 *
+	 * @param bytesPerSecond the minimum throughput in bytes per second
+	 * @param window the time span in milliseconds the throughput is averaged over
+	 * @see setRetryPolicy
+	 */
+	static void setMinThroughput(int bytesPerSecond, int window = 10000);
+
+	/**
+	 * @brief Limits the bandwidth used for downloading files
+	 *
+	 * Tarballs, zipballs and files downloaded with @c downloadFile are
+	 * throttled to share @c bytesPerSecond, and each of them to
+	 * @c perTransferBytesPerSecond. API requests, avatars and images embedded
+	 * into bodies are never throttled, but take their share of
+	 * @c bytesPerSecond first.
+	 *
+	 * @note defaults to @c 0, i.e. unlimited
+	 * @note the per-transfer limit applies to downloads started afterwards
+	 *
+	 * @param bytesPerSecond the total bandwidth in bytes per second, @c 0 for unlimited
+	 * @param perTransferBytesPerSecond the bandwidth per file download in bytes
+	 * per second, @c 0 for unlimited
+	 */
+	static void setBandwidthLimit(int bytesPerSecond, int perTransferBytesPerSecond = 0);
+
+	/**
+	 * @brief Allows HTTP/2 for all requests
+	 *
+	 * Requests of a thread share their connections. With HTTP/2 the release
+	 * information, the emoji table, avatars and images of a host are
+	 * multiplexed over a single connection. Servers not offering HTTP/2 are
+	 * talked to via HTTP/1.1, and a host failing with HTTP/2 is retried and
+	 * used with HTTP/1.1 from then on.
+	 *
+	 * @note defaults to @c false
+	 * @note requests issued from different threads, e.g. by the download
+	 * worker and the synchronous calls, use connections of their own and
+	 * are not multiplexed with each other
+	 * @note requires Qt 5.8 or newer, ignored otherwise
+	 *
+	 * @param enabled @c true to allow HTTP/2, @c false otherwise
+	 */
+	static void setHttp2Enabled(bool enabled);
+
 	/**
 	 * @brief The api URL
 	 * @return the api URL
@@ -206,9 +435,17 @@ public:
 
 	/**
 	 * @brief Downloads the file at @c QUrl into a file
+	 *
+	 * If @c outputFile is not open, the download is written to a temporary file
+	 * next to it, synced to disk and renamed to @c outputFile only on success.
+	 * Thus @c outputFile is either replaced completely or left untouched. An
+	 * open @c outputFile is written to directly.
+	 *
+	 * @note the same applies to @c tarBall(QFile&) and @c zipBall(QFile&)
+	 *
 	 * @param url the URL to download from
 	 * @param outputFile the file to download to
-	 * @return the number of received bytes
+	 * @return the number of received bytes or @c -1 on failure
 	 */
 	qint64 downloadToFile(const QUrl &url, QFile &outputFile) const;
 
@@ -236,12 +473,52 @@ public:
 	 */
 	QVariantList toVariantList() const;
 
+	/**
+	 * @brief Takes an immutable snapshot of the release information
+	 *
+	 * The snapshot shares the release information with this instance instead of
+	 * copying it. It can be handed to other threads and outlives this instance.
+	 *
+	 * @note include @em qgithubreleasesnapshot.h to use it
+	 *
+	 * @return the snapshot, a null snapshot if no release information is available
+	 * @see QGitHubReleaseSnapshot
+	 */
+	QGitHubReleaseSnapshot snapshot() const;
+
 	/**
 	 * @brief Gets the release information as raw Json data
 	 * @return
 	 */
 	QByteArray asJsonData() const;
 
+	/**
+	 * @brief Saves the release information into a snapshot
+	 *
+	 * The snapshot is a versioned binary file containing the parsed release information
+	 * as well as all bodies and avatars retrieved so far. It can get loaded without
+	 * any network access by the according constructor.
+	 *
+	 * @param snapshot the file to save the snapshot to
+	 * @return @c true on success, @c false otherwise
+	 */
+	bool saveSnapshot(QFile &snapshot) const;
+
+	/**
+	 * @brief Saves the release information into an index
+	 *
+	 * The index keeps the scalar fields of every release in fixed-size records and
+	 * all strings in a separate heap. In contrast to a snapshot it gets memory-mapped
+	 * on loading, thus only the entries actually accessed are paged in. This is
+	 * suitable for repositories with a very large release history.
+	 *
+	 * @note bodies and avatars are not part of the index
+	 *
+	 * @param index the file to save the index to
+	 * @return @c true on success, @c false otherwise
+	 */
+	bool saveIndex(QFile &index) const;
+
 	/**
 	 * @name Accessing the release information
 	 * @{
@@ -269,6 +546,113 @@ public:
 
 	/// @}
 
+	/**
+	 * @brief Downloads the tarball and unpacks it while downloading
+	 *
+	 * The archive is never stored, each chunk is decompressed and unpacked as it
+	 * arrives. The leading directory GitHub puts all files into is stripped, i.e.
+	 * the files of the repository end up directly in @c directory.
+	 *
+	 * Entries pointing outside of @c directory abort the extraction, links and
+	 * special files are skipped.
+	 *
+	 * @note requires @em zlib
+	 *
+	 * @param directory the directory to unpack into, created if needed
+	 * @param filters wildcard patterns matched against the paths within the archive,
+	 * i.e. @em translations/\*.qm, only matching files are unpacked if not empty
+	 * @param idx the entry index
+	 * @return the number of received bytes or @c -1 on failure
+	 */
+	qint64 extractTarBall(const QString &directory, const QStringList &filters = QStringList(),
+						  int idx = 0) const;
+
+	/**
+	 * @brief Downloads the zipball and unpacks it while downloading
+	 *
+	 * Works like @c extractTarBall, the checksums of the entries are verified.
+	 *
+	 * @note deflated entries require @em zlib
+	 *
+	 * @param directory the directory to unpack into, created if needed
+	 * @param filters wildcard patterns matched against the paths within the archive,
+	 * only matching files are unpacked if not empty
+	 * @param idx the entry index
+	 * @return the number of received bytes or @c -1 on failure
+	 * @see extractTarBall
+	 */
+	qint64 extractZipBall(const QString &directory, const QStringList &filters = QStringList(),
+						  int idx = 0) const;
+
+	/**
+	 * @name Querying the release information
+	 *
+	 * The lookup tables are built on the first query and kept until the release
+	 * information changes, subsequent queries don't scan the entries.
+	 *
+	 * @{
+	 */
+
+	/**
+	 * @brief Finds the entry with a given tag name
+	 * @param tag the tag name
+	 * @return the entry index or @c -1 if there is no such entry
+	 */
+	int indexOfTag(const QString &tag) const;
+
+	/**
+	 * @brief Finds the entry with a given release id
+	 * @param id the release id
+	 * @return the entry index or @c -1 if there is no such entry
+	 */
+	int indexOfId(ulong id) const;
+
+	/**
+	 * @brief Finds all entries published in a given period
+	 *
+	 * An invalid @c from or @c to leaves the period open at the according side.
+	 * Entries without a publishing date (i.e. drafts) are never part of the result.
+	 *
+	 * @param from the begin of the period (inclusive)
+	 * @param to the end of the period (inclusive)
+	 * @return the entry indices ordered by the date of publishing
+	 */
+	QList<int> releasesBetween(const QDateTime &from, const QDateTime &to) const;
+
+	/**
+	 * @brief Finds the newest release being neither a draft nor a pre-release
+	 * @return the entry index or @c -1 if there is no such entry
+	 */
+	int indexOfNewestRelease() const;
+
+	/**
+	 * @brief All entries ordered by the version in their tag names
+	 *
+	 * Tag names are parsed as semantic versions once the release information
+	 * is available. Leading non-digits (like in @em V0.23) are skipped and
+	 * loose versions (like @em 1.0rc1) are accepted. Entries whose tag name
+	 * contains no version are put at the end.
+	 *
+	 * @return the entry indices, newest version first
+	 */
+	QList<int> sortedByVersion() const;
+
+	/**
+	 * @brief Finds all entries newer than a given version
+	 *
+	 * Useful to check for updates of an installed version.
+	 *
+	 * @param version the version to compare to, i.e. the installed one
+	 * @param preReleases @c true to include entries flagged as pre-release
+	 * @param drafts @c true to include entries flagged as draft
+	 * @return the entry indices, newest version first
+	 * @see sortedByVersion
+	 */
+	QList<int> newerThan(const QString &version, bool preReleases = false,
+						 bool drafts = false) const;
+
+	/// @}
+
 	/**
 	 * @name Accessing the user information
 	 * @{
@@ -322,6 +706,15 @@ signals:
 	 */
 	void available(const QGitHubReleaseAPI &api);
 
+	/**
+	 * @brief Emitted if a refresh found the release data unchanged
+	 *
+	 * The release data is kept as is and no @c available signal is emitted.
+	 *
+	 * @see refresh
+	 */
+	void notModified();
+
 	/**
 	 * @brief Emitted on any error
 	 * @param error the error string
@@ -344,14 +737,83 @@ signals:
 	 */
 	void progress(qint64 bytesReceived, qint64 bytesTotal);
 
+	/**
+	 * @brief Emitted if a body requested by @c requestBody is available
+	 * @param idx the entry index
+	 * @param body the rendered body
+	 */
+	void bodyAvailable(int idx, const QString &body);
+
+	/**
+	 * @brief Emitted if an avatar requested by @c requestAvatar is available
+	 * @param idx the entry index
+	 * @param avatar the avatar image
+	 */
+	void avatarAvailable(int idx, const QImage &avatar);
+
+	/**
+	 * @brief Emitted if all bodies requested by @c renderAllBodies are available
+	 */
+	void bodiesRendered();
+
 public slots:
 	/**
 	 * @brief Cancels the current operation
 	 */
 	void cancel();
 
+	/**
+	 * @brief Requests the release information again
+	 *
+	 * If release data is already available, the request is conditional on the
+	 * current @c eTag. If nothing has changed @c notModified is emitted and the
+	 * release data is kept, otherwise it is replaced and @c available is emitted.
+	 *
+	 * @note conditional requests, which are answered with @c 304 don't count
+	 * against the rate limit
+	 */
+	void refresh();
+
+	/**
+	 * @brief Requests the body without blocking
+	 *
+	 * The body gets rendered, including the download of embedded images, on the
+	 * global @c QThreadPool. @c bodyAvailable is emitted as soon as it is done.
+	 *
+	 * @param idx the entry index
+	 * @see body
+	 */
+	void requestBody(int idx = 0);
+
+	/**
+	 * @brief Requests the avatar without blocking
+	 *
+	 * The avatar gets downloaded and decoded on the global @c QThreadPool.
+	 * @c avatarAvailable is emitted as soon as it is done.
+	 *
+	 * @param idx the entry index
+	 * @see avatar
+	 */
+	void requestAvatar(int idx = 0);
+
+	/**
+	 * @brief Renders the bodies of all entries in parallel
+	 *
+	 * The bodies not yet rendered are distributed over the global @c QThreadPool.
+	 * Images and emojis shared between the bodies are downloaded only once.
+	 * @c bodyAvailable is emitted for each body and @c bodiesRendered after the
+	 * last one. Afterwards @c body returns the cached result.
+	 *
+	 * @see requestBody
+	 */
+	void renderAllBodies();
+
 private slots:
 	void apiAvailable();
+	void apiNotModified();
+	void apiBodyAvailable(int, const QString &);
+	void apiAvatarAvailable(int, const QImage &);
+	void apiBodiesRendered();
 	void apiCanceled();
 	void apiError(const QString &);
 	void apiDownloadProgress(qint64, qint64);
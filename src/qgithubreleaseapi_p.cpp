@@ -18,127 +18,251 @@
  */
 
 #include <QBuffer>
-#include <QRegExp>
+#include <QDataStream>
+#include <QtAlgorithms>
 #include <QEventLoop>
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) || defined(QJSON_FOUND)
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-#include <QJsonDocument>
-#else
-#include <qjson/parser.h>
-#endif
-#ifdef HAVE_MKDIO_H
-extern "C" {
-#include <mkdio.h>
-}
-#endif
-#endif
+#include <QThreadPool>
 
 #include "qgithubreleaseapi_p.h"
-#include "filedownloader.h"
+#include "releasestore.h"
+#include "releasedata.h"
 #include "entryhelper.h"
-#include "emoji.h"
+#include "downloadcontext.h"
+#include "filesink.h"
+#include "resourcecache.h"
+#include "apiworker.h"
+#include "jsonindex.h"
+#include "asyncjob.h"
+
+namespace {
+
+struct VersionGreater {
+
+	explicit VersionGreater(const QVector<Version> &v) : versions(v) {}
+
+	bool operator()(int a, int b) const {
+		return versions[a].isValid() != versions[b].isValid() ? versions[a].isValid() :
+																versions[b] < versions[a];
+	}
+
+	const QVector<Version> &versions;
+};
+
+struct ApiBase {
+
+	ApiBase() : mutex(), url(QUrl(QLatin1String("https://api.github.com"))) {}
+
+	QMutex mutex;
+	QUrl url;
+};
+
+}
+
+Q_GLOBAL_STATIC(ApiBase, apiBase)
 
 const char *QGitHubReleaseAPIPrivate::m_userAgent = "QGitHubReleaseAPI";
+bool QGitHubReleaseAPIPrivate::m_workerThreadEnabled = false;
 const char *QGitHubReleaseAPIPrivate::m_outOfBoundsError =
 		QT_TRANSLATE_NOOP("QGitHubReleaseAPIPrivate", "Index %1 >= %2 (out of bounds)");
 const char *QGitHubReleaseAPIPrivate::m_noDataAvailableError =
 		QT_TRANSLATE_NOOP("QGitHubReleaseAPIPrivate", "No data available");
 
+const quint32 QGitHubReleaseAPIPrivate::m_snapshotMagic   = 0x51474852; // QGHR
+const quint16 QGitHubReleaseAPIPrivate::m_snapshotVersion = 1;
+
+void QGitHubReleaseAPIPrivate::setLazyParsingEnabled(bool b) {
+	ApiWorker::setLazyParsing(b);
+}
+
+void QGitHubReleaseAPIPrivate::setApiBaseUrl(const QUrl &url) {
+	QMutexLocker lock(&apiBase()->mutex);
+	apiBase()->url = url.isValid() ? url : QUrl(QLatin1String("https://api.github.com"));
+}
+
+QUrl QGitHubReleaseAPIPrivate::apiBaseUrl() {
+	QMutexLocker lock(&apiBase()->mutex);
+	return apiBase()->url;
+}
+
+QUrl QGitHubReleaseAPIPrivate::apiEndpoint(const QString &path, const QUrl &baseUrl) {
+
+	QString base((baseUrl.isValid() ? baseUrl : apiBaseUrl()).toString());
+
+	// Enterprise instances serve the API below a path, e.g. /api/v3
+	while(base.endsWith(QLatin1Char('/'))) base.chop(1);
+
+	return QUrl(base + path);
+}
+
+QUrl QGitHubReleaseAPIPrivate::releasesApiUrl(const QString &user, const QString &repo,
+											  int perPage, const QUrl &baseUrl) {
+	return apiEndpoint(QString("/repos/%1/%2/releases?per_page=%3").
+					   arg(QString(QUrl::toPercentEncoding(user))).
+					   arg(QString(QUrl::toPercentEncoding(repo))).arg(perPage), baseUrl);
+}
+
+QUrl QGitHubReleaseAPIPrivate::latestReleaseApiUrl(const QString &user, const QString &repo,
+												   const QUrl &baseUrl) {
+	return apiEndpoint(QString("/repos/%1/%2/releases/latest").
+					   arg(QString(QUrl::toPercentEncoding(user))).
+					   arg(QString(QUrl::toPercentEncoding(repo))), baseUrl);
+}
+
+QUrl QGitHubReleaseAPIPrivate::tagReleaseApiUrl(const QString &user, const QString &repo,
+												const QString &tag, const QUrl &baseUrl) {
+	return apiEndpoint(QString("/repos/%1/%2/releases/tags/%3").
+					   arg(QString(QUrl::toPercentEncoding(user))).
+					   arg(QString(QUrl::toPercentEncoding(repo))).
+					   arg(QString(QUrl::toPercentEncoding(tag))), baseUrl);
+}
+
 QGitHubReleaseAPIPrivate::QGitHubReleaseAPIPrivate(const QUrl &apiUrl, bool multi,
 												   QGitHubReleaseAPI::TYPE type, QObject *p) :
-	QObject(p), m_apiDownloader(new FileDownloader(apiUrl, m_userAgent)), m_jsonData(), m_vdata(),
+	QObject(p), m_apiWorker(new ApiWorker(apiUrl, m_userAgent)), m_jsonData(), m_vdata(),
 	m_errorString(), m_rateLimit(0), m_rateLimitRemaining(0), m_singleEntryRequested(!multi),
-	m_rateLimitReset(), m_avatars(), m_eTag(QString::null), m_dlOutputFile(0L),
-	m_readBytes(Q_INT64_C(-1)), m_readReply(0L), m_bytesAvail(Q_INT64_C(-1)), m_type(type) {
+	m_rateLimitReset(), m_avatars(), m_bodies(), m_eTag(QString::null), m_type(type),
+	m_store(), m_jsonIndex(), m_renderingAll(false) {
 	init();
 }
 
 QGitHubReleaseAPIPrivate::QGitHubReleaseAPIPrivate(const QUrl &apiUrl, bool multi,
 												   QGitHubReleaseAPI::TYPE type,
 												   const QString &etag, QObject *p) :
-	QObject(p), m_apiDownloader(new FileDownloader(apiUrl, m_userAgent)), m_jsonData(), m_vdata(),
+	QObject(p), m_apiWorker(new ApiWorker(apiUrl, m_userAgent)), m_jsonData(), m_vdata(),
 	m_errorString(), m_rateLimit(0), m_rateLimitRemaining(0), m_singleEntryRequested(!multi),
-	m_rateLimitReset(), m_avatars(), m_eTag(etag), m_dlOutputFile(0L), m_readBytes(Q_INT64_C(-1)),
-	m_readReply(0L), m_bytesAvail(Q_INT64_C(-1)), m_type(type) {
+	m_rateLimitReset(), m_avatars(), m_bodies(), m_eTag(etag), m_type(type),
+	m_store(), m_jsonIndex(), m_renderingAll(false) {
 	init();
 }
 
 QGitHubReleaseAPIPrivate::QGitHubReleaseAPIPrivate(const QString &user, const QString &repo,
 												   bool latest, QGitHubReleaseAPI::TYPE type,
 												   QObject *p) : QObject(p),
-	m_apiDownloader(new FileDownloader(QUrl(QString("https://api.github.com/repos/%1/%2/releases%3")
-											.arg(QString(QUrl::toPercentEncoding(user)))
-											.arg(QString(QUrl::toPercentEncoding(repo)))
-											.arg(latest ? "/latest" : "")), m_userAgent)),
+	m_apiWorker(new ApiWorker(latest ? latestReleaseApiUrl(user, repo) :
+									   apiEndpoint(QString("/repos/%1/%2/releases").
+												   arg(QString(QUrl::toPercentEncoding(user))).
+												   arg(QString(QUrl::toPercentEncoding(repo)))),
+							  m_userAgent)),
 	m_jsonData(), m_vdata(), m_errorString(), m_rateLimit(0), m_rateLimitRemaining(0),
-	m_singleEntryRequested(latest), m_rateLimitReset(), m_avatars(), m_eTag(QString::null),
-	m_dlOutputFile(0L), m_readBytes(Q_INT64_C(-1)), m_readReply(0L), m_bytesAvail(Q_INT64_C(-1)),
-	m_type(type) {
+	m_singleEntryRequested(latest), m_rateLimitReset(), m_avatars(), m_bodies(),
+	m_eTag(QString::null), m_type(type), m_store(), m_jsonIndex(), m_renderingAll(false) {
 	init();
 }
 
 QGitHubReleaseAPIPrivate::QGitHubReleaseAPIPrivate(const QString &user, const QString &repo,
 												   const QString &tag, QGitHubReleaseAPI::TYPE type,
 												   QObject *p) : QObject(p),
-	m_apiDownloader(new FileDownloader(QUrl(QString("https://api.github.com/repos/%1/%2" \
-													"/releases/tags/%3")
-											.arg(QString(QUrl::toPercentEncoding(user)))
-											.arg(QString(QUrl::toPercentEncoding(repo)))
-											.arg(QString(QUrl::toPercentEncoding(tag)))),
-									   m_userAgent)), m_jsonData(), m_errorString(),
-	m_rateLimit(0), m_rateLimitRemaining(0), m_singleEntryRequested(true), m_avatars(),
-	m_eTag(QString::null), m_type(type) {
+	m_apiWorker(new ApiWorker(tagReleaseApiUrl(user, repo, tag), m_userAgent)), m_jsonData(),
+	m_errorString(), m_rateLimit(0), m_rateLimitRemaining(0), m_singleEntryRequested(true),
+	m_avatars(), m_bodies(), m_eTag(QString::null), m_type(type), m_store(), m_jsonIndex(),
+	m_renderingAll(false) {
 	init();
 }
 
 QGitHubReleaseAPIPrivate::QGitHubReleaseAPIPrivate(const QString &user, const QString &repo,
 												   int limit, QGitHubReleaseAPI::TYPE type,
 												   QObject *p) : QObject(p),
-	m_apiDownloader(new FileDownloader(QUrl(QString("https://api.github.com/repos/%1/%2/" \
-													"releases?per_page=%3").
-											arg(QString(QUrl::toPercentEncoding(user))).
-											arg(QString(QUrl::toPercentEncoding(repo))).
-											arg(limit)), m_userAgent)), m_jsonData(),
+	m_apiWorker(new ApiWorker(releasesApiUrl(user, repo, limit), m_userAgent)), m_jsonData(),
 	m_errorString(), m_rateLimit(0), m_rateLimitRemaining(0), m_singleEntryRequested(false),
-	m_avatars(), m_eTag(QString::null), m_type(type) {
+	m_avatars(), m_bodies(), m_eTag(QString::null), m_type(type), m_store(), m_jsonIndex(),
+	m_renderingAll(false) {
 	init();
 }
 
+QGitHubReleaseAPIPrivate::QGitHubReleaseAPIPrivate(QFile &snapshot, QObject *p) : QObject(p),
+	m_apiWorker(0L), m_jsonData(), m_vdata(), m_errorString(), m_rateLimit(0),
+	m_rateLimitRemaining(0), m_singleEntryRequested(false), m_rateLimitReset(), m_avatars(),
+	m_bodies(), m_eTag(QString::null), m_type(QGitHubReleaseAPI::RAW), m_store(), m_jsonIndex(),
+	m_renderingAll(false) {
+
+	QUrl url;
+
+	if(!snapshot.isOpen() && !snapshot.open(QFile::ReadOnly)) {
+		m_errorString = snapshot.errorString();
+	} else if(ReleaseStore::isStore(snapshot)) {
+
+		ReleaseStore *store = new ReleaseStore(snapshot.fileName());
+
+		if(store->isValid()) {
+			url = store->apiUrl();
+			m_eTag = store->eTag();
+			m_type = store->type();
+			m_singleEntryRequested = store->singleEntry();
+			m_store = QSharedPointer<const ReleaseStore>(store);
+		} else {
+			m_errorString = store->errorString();
+			delete store;
+		}
+
+	} else if(!loadSnapshot(snapshot, url)) {
+		m_vdata.clear();
+	}
+
+	parseVersions();
+
+	m_apiWorker = new ApiWorker(url, m_userAgent, m_eTag);
+
+	init(false);
+
+	QMetaObject::invokeMethod(this, "snapshotLoaded", Qt::QueuedConnection);
+}
+
 QGitHubReleaseAPIPrivate::~QGitHubReleaseAPIPrivate() {
 	cancel();
-	delete m_apiDownloader;
+
+	if(m_apiWorker->thread() == thread()) {
+		delete m_apiWorker;
+	} else {
+		m_apiWorker->disconnect(this);
+		QMetaObject::invokeMethod(m_apiWorker, "cancel");
+		m_apiWorker->deleteLater();
+	}
 }
 
-void QGitHubReleaseAPIPrivate::init() const {
+void QGitHubReleaseAPIPrivate::init(bool start) const {
 
-	QObject::connect(m_apiDownloader, SIGNAL(error(QString)), this, SLOT(fdError(QString)));
-	QObject::connect(m_apiDownloader, SIGNAL(downloaded(FileDownloader)),
-					 this, SLOT(downloaded(FileDownloader)));
-	QObject::connect(m_apiDownloader, SIGNAL(progress(qint64,qint64)),
+	if(m_workerThreadEnabled) m_apiWorker->moveToThread(ApiWorker::workerThread());
+
+	QObject::connect(m_apiWorker, SIGNAL(error(QString)), this, SLOT(fdError(QString)));
+	QObject::connect(m_apiWorker, SIGNAL(finished(QByteArray,QVariant,QString,int,
+												  FileDownloader::RAWHEADERPAIRLIST)),
+					 this, SLOT(apiFinished(QByteArray,QVariant,QString,int,
+											FileDownloader::RAWHEADERPAIRLIST)));
+	QObject::connect(m_apiWorker, SIGNAL(progress(qint64,qint64)),
 					 this, SLOT(downloadProgress(qint64,qint64)));
 
-	m_apiDownloader->start(m_type);
+	if(start) {
+		QMetaObject::invokeMethod(m_apiWorker, "start", Q_ARG(int, m_type),
+								  Q_ARG(QString, QString::null));
+	}
 }
 
 QImage QGitHubReleaseAPIPrivate::avatar(int idx) const {
 
-	if(m_avatars.contains(idx)) {
-		return m_avatars.value(idx);
-	} else {
-		QImage img = QImage::fromData(downloadFile(avatarUrl(idx)));
-		if(!img.isNull()) return *m_avatars.insert(idx, img);
+	{
+		QReadLocker lock(&m_cacheLock);
+		if(m_avatars.contains(idx)) return m_avatars.value(idx);
+	}
+
+	const QImage img(QImage::fromData(downloadFile(avatarUrl(idx), false,
+													FileDownloader::HIGH)));
+
+	if(!img.isNull()) {
+		QWriteLocker lock(&m_cacheLock);
+		return *m_avatars.insert(idx, img);
 	}
 
 	return QImage();
 }
 
-QByteArray QGitHubReleaseAPIPrivate::downloadFile(const QUrl &u, bool generic) const {
+QByteArray QGitHubReleaseAPIPrivate::downloadFile(const QUrl &u, bool generic,
+												  FileDownloader::PRIORITY priority) const {
 
 	QByteArray ba;
 	QBuffer buf(&ba);
 
-	if(!(buf.open(QIODevice::WriteOnly) && downloadFile(u, &buf, generic) != Q_INT64_C(-1))) {
+	if(!(buf.open(QIODevice::WriteOnly) &&
+		 downloadFile(u, &buf, generic, priority) != Q_INT64_C(-1))) {
 		emit error(buf.errorString());
 	}
 
@@ -147,52 +271,55 @@ QByteArray QGitHubReleaseAPIPrivate::downloadFile(const QUrl &u, bool generic) c
 	return ba;
 }
 
-qint64 QGitHubReleaseAPIPrivate::downloadFile(const QUrl &u, QIODevice *of, bool generic) const {
+qint64 QGitHubReleaseAPIPrivate::downloadFile(const QUrl &u, QIODevice *of, bool generic,
+											  FileDownloader::PRIORITY priority) const {
 
-	m_readBytes = Q_INT64_C(-1);
+	if(!of) return Q_INT64_C(-1);
 
-	if(of) {
+	FileDownloader dl(u, m_userAgent, m_eTag);
+	DownloadContext ctx(of);
 
-		QEventLoop wait;
-		FileDownloader dl(u, m_userAgent, m_eTag);
+	dl.setCacheLoadControlAttribute(QNetworkRequest::PreferCache);
+	dl.setGeneric(generic);
+	dl.setPriority(priority);
 
-		m_dlOutputFile = of;
+	QObject::connect(&dl, SIGNAL(canceled()), this, SLOT(fdCanceled()));
+	QObject::connect(&dl, SIGNAL(error(QString)), this, SLOT(fileDownloadError(QString)));
+	QObject::connect(&dl, SIGNAL(progress(qint64,qint64)),
+					 this, SLOT(fileDownloadProgress(qint64,qint64)));
 
-		dl.setCacheLoadControlAttribute(QNetworkRequest::PreferCache);
-		dl.setGeneric(generic);
+	m_downloadsMutex.lock();
+	m_downloads.insert(&ctx);
+	m_downloadsMutex.unlock();
 
-		QObject::connect(&dl, SIGNAL(canceled()), &wait, SLOT(quit()));
-		QObject::connect(&dl, SIGNAL(error(QString)), &wait, SLOT(quit()));
-		QObject::connect(&dl, SIGNAL(downloaded(FileDownloader)), &wait, SLOT(quit()));
-		QObject::connect(&dl, SIGNAL(replyChanged(QNetworkReply*)),
-						 this, SLOT(updateReply(QNetworkReply*)));
-		QObject::connect(&dl, SIGNAL(canceled()), this, SLOT(fdCanceled()));
-		QObject::connect(&dl, SIGNAL(error(QString)), this, SLOT(fileDownloadError(QString)));
-		QObject::connect(&dl, SIGNAL(progress(qint64,qint64)),
-						 this, SLOT(fileDownloadProgress(qint64,qint64)));
+	const qint64 readBytes = ctx.run(dl);
 
-		m_readReply = dl.start(QGitHubReleaseAPI::RAW);
+	m_downloadsMutex.lock();
+	m_downloads.remove(&ctx);
+	m_downloadsMutex.unlock();
 
-		QObject::connect(m_readReply, SIGNAL(readyRead()), this, SLOT(readChunk()));
-		wait.exec();
+	return readBytes;
+}
 
-		m_dlOutputFile = 0L;
-	}
+qint64 QGitHubReleaseAPIPrivate::downloadFile(const QUrl &u, QFile &of) const {
 
-	m_readReply = 0L;
+	// an open file is the caller's business
+	if(of.isOpen()) return downloadFile(u, &of);
 
-	return m_readBytes;
-}
+	FileSink sink(of.fileName());
+
+	if(!sink.open(QIODevice::WriteOnly)) {
+		emit error(sink.errorString());
+		return Q_INT64_C(-1);
+	}
 
-void QGitHubReleaseAPIPrivate::updateReply(QNetworkReply *r) {
+	qint64 r = downloadFile(u, &sink);
 
-	QObject::disconnect(m_readReply, SIGNAL(readyRead()), this, SLOT(readChunk()));
-	QObject::connect(r, SIGNAL(readyRead()), this, SLOT(readChunk()));
-	m_readReply = r;
-}
+	if(r != Q_INT64_C(-1) && !sink.commit()) r = Q_INT64_C(-1);
 
-void QGitHubReleaseAPIPrivate::readChunk() {
-	m_readBytes += m_dlOutputFile->write(m_readReply->readAll());
+	if(sink.hasFailed()) emit error(sink.errorString());
+
+	return r;
 }
 
 void QGitHubReleaseAPIPrivate::fileDownloadError(const QString &err) {
@@ -209,62 +336,33 @@ void QGitHubReleaseAPIPrivate::fdError(const QString &err) {
 
 void QGitHubReleaseAPIPrivate::fdCanceled() {
 	qWarning("Download canceled");
-	m_readBytes = Q_INT64_C(-1);
 	emit canceled();
 }
 
 QString QGitHubReleaseAPIPrivate::body(int idx) const {
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) || defined(QJSON_FOUND))
 
+	{
+		QReadLocker lock(&m_cacheLock);
+		if(m_bodies.contains(idx)) return m_bodies.value(idx);
+	}
+
 	if(dataAvailable()) {
 
 		if(entries() > idx) {
-#ifdef HAVE_MKDIO_H
-			const QString bMD(m_vdata[idx].toMap()["body"].toString());
 
-#if QT_VERSION >= QT_VERSION_CHECK(4, 5, 0)
-			const mkd_flag_t f = MKD_TOC|MKD_AUTOLINK|MKD_NOEXT|MKD_NOHEADER;
-#else
-			const mkd_flag_t f = MKD_TOC|MKD_AUTOLINK|MKD_NOEXT|MKD_NOHEADER|MKD_NOIMAGE;
-#endif
-#endif
-
-			switch(m_type) {
-#ifdef HAVE_MKDIO_H
-			case QGitHubReleaseAPI::RAW: {
-					MMIOT *doc = 0L;
-					char *html = 0L;
-					int dlen   = EOF;
-
-					if((doc = mkd_string(bMD.toStdString().c_str(), bMD.length(), f)) &&
-							mkd_compile(doc, f) != EOF && (dlen = mkd_document(doc, &html)) != EOF) {
-
-						QString b(QString::fromUtf8((QByteArray(html,
-																dlen).append('\0')).constData()));
-						mkd_cleanup(doc);
+			QString err;
+			ResourceCache rc(m_userAgent);
+			const QString &b(BodyRenderer(m_type, rc).
+							 render(value(idx, BodyRenderer::field(m_type)).toString(), err));
 
-						return embedImages(b);
-
-					} else {
-						emit error(tr("libmarkdown: parsing failed"));
-					}
-
-				} break;
-#else
-			case QGitHubReleaseAPI::RAW:
-#endif
-			case QGitHubReleaseAPI::HTML: {
-					QString b(m_vdata[idx].toMap()["body_html"].toString());
-					return embedImages(b);
-				} break;
-			default:
-				return m_vdata[idx].toMap()["body_text"].toString().
-						append(QString::fromUtf8("\n\n--\nRelease information provided by " \
-						"QGitHubReleaseAPI "
-						PROJECTVERSION
-						" \u00a9 2015 Heiko Sch\u00e4fer <heiko@rangun.de>"));
+			if(err.isNull()) {
+				QWriteLocker lock(&m_cacheLock);
+				return *m_bodies.insert(idx, b);
 			}
 
+			emit error(err);
+
 		} else {
 			emit error(QString(m_outOfBoundsError).arg(entries()).arg(idx));
 		}
@@ -280,140 +378,188 @@ QString QGitHubReleaseAPIPrivate::body(int idx) const {
 	return QString::null;
 }
 
-QString QGitHubReleaseAPIPrivate::embedImages(QString &b) const {
-#if QT_VERSION >= QT_VERSION_CHECK(4, 5, 0)
+void QGitHubReleaseAPIPrivate::requestBody(int idx) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) || defined(QJSON_FOUND))
 
-	QRegExp emjRex(":([_a-zA-Z0-9]+):");
-	QRegExp imgRex("<[^<]*img[^>]*src\\s*=\\s*\"([^\"]*)\"[^>]*>");
+	if(!dataAvailable()) {
+		emit error(m_noDataAvailableError);
+		return;
+	}
 
-	Emoji *emoji = 0L;
+	if(entries() <= idx) {
+		emit error(QString(m_outOfBoundsError).arg(entries()).arg(idx));
+		return;
+	}
 
-	int idx = -1;
+	QWriteLocker lock(&m_cacheLock);
 
-	while((idx = b.indexOf(emjRex, idx + 1)) != -1) {
+	if(m_bodies.contains(idx)) {
 
-		const QString emjKey(emjRex.cap(1));
+		const QString b(m_bodies.value(idx));
 
-		if(!emoji) {
-			QEventLoop emjLoop;
-			QObject::connect((emoji = new Emoji(eTag())), SIGNAL(available()),
-							 &emjLoop, SLOT(quit()));
-			if(!emoji->entries()) emjLoop.exec();
-		}
+		lock.unlock();
+		emit bodyAvailable(idx, b);
 
-		const QUrl &emjUrl(emoji->getUrl(emjKey));
+	} else if(!m_pendingBodies.contains(idx)) {
 
-		if(emjUrl.isValid()) {
-			b.replace(idx, emjKey.length() + 2, "<img width=\"16\" height=\"16\" alt=\"" + emjKey +
-					  "\" src=\"" + emjUrl.toString() + "\">");
-		}
+		m_pendingBodies.insert(idx);
+		lock.unlock();
 
-		idx += emjKey.length() + 1;
+		startBodyJob(idx);
 	}
 
-	delete emoji;
+#else
+	Q_UNUSED(idx)
+	emit error(tr("No JSon parser available, body not available"));
+#endif
+}
 
-	idx = -1;
+void QGitHubReleaseAPIPrivate::renderAllBodies() {
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) || defined(QJSON_FOUND))
 
-	while((idx = b.indexOf(imgRex, idx + 1)) != -1) {
+	if(!dataAvailable()) {
+		emit error(m_noDataAvailableError);
+		return;
+	}
 
-		const QUrl url = QUrl(imgRex.cap(1));
+	QList<int> jobs;
+	QWriteLocker lock(&m_cacheLock);
 
-		if(url.isValid()) {
+	for(int i = 0; i < entries(); ++i) {
 
-			const QImage img = QImage::fromData(downloadFile(url));
+		if(!(m_bodies.contains(i) || m_pendingBodies.contains(i))) {
+			m_pendingBodies.insert(i);
+			jobs.append(i);
+		}
+	}
 
-			if(!img.isNull()) {
+	const bool done = m_pendingBodies.isEmpty();
 
-				QByteArray ba;
-				QBuffer buf(&ba);
-				buf.open(QIODevice::WriteOnly);
-				img.save(&buf, "PNG");
-				ba.squeeze();
+	m_renderingAll = !done;
+	lock.unlock();
 
-				b.replace(imgRex.pos(1), imgRex.cap(1).length(),
-						  QString("data:image/png;base64,%1").
-						  arg(ba.toBase64().constData()));
-			}
-		}
+	if(done) {
+		emit bodiesRendered();
+		return;
 	}
+
+	foreach(int i, jobs) startBodyJob(i);
+
+#else
+	// without a JSon parser there is nothing to render, libmarkdown or not
+	emit error(tr("No JSon parser available, bodies not available"));
 #endif
+}
 
-	b.append("<hr /><p>Release information provided by " \
-			 "<em>QGitHubReleaseAPI "
-			 PROJECTVERSION
-			 "</em> &copy; 2015 " \
-			 "Heiko Sch&auml;fer &lt;<a href=\"mailto:heiko@rangun.de?" \
-			 "subject=QGitHubReleaseAPI%20"
-			 PROJECTVERSION
-			 "\">heiko@rangun.de</a>&gt;");
+void QGitHubReleaseAPIPrivate::startBodyJob(int idx) {
 
-#ifdef HAVE_MKDIO_H
-	if(m_type == QGitHubReleaseAPI::RAW) {
-		b.append(QString("<br />Markdown rendered with <em>libmarkdown %1</em>").
-				 arg(markdown_version));
+	// shared by all jobs in flight, thus images and emojis are downloaded only once
+	if(m_resources.isNull()) {
+		m_resources = QSharedPointer<ResourceCache>(new ResourceCache(m_userAgent));
 	}
-#endif
 
-	return b.append("</p>");
-}
+	JobNotifier *n = new JobNotifier();
 
-void QGitHubReleaseAPIPrivate::downloadProgress(qint64 br, qint64 bt) {
-	emit progress(br, bt);
+	QObject::connect(n, SIGNAL(bodyRendered(int,QString,QString)),
+					 this, SLOT(bodyRendered(int,QString,QString)));
+
+	QThreadPool::globalInstance()->start(new BodyJob(n, idx, value(idx,
+										 BodyRenderer::field(m_type)).toString(),
+										 m_type, m_resources));
 }
 
-QVariant QGitHubReleaseAPIPrivate::parseJSon(const QByteArray &ba, QString &err) const {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) || defined(QJSON_FOUND)
-#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
-	QJson::Parser parser;
-	bool ok = false;
-#else
-	QJsonParseError ok;
-#endif
+void QGitHubReleaseAPIPrivate::bodyRendered(int idx, const QString &b, const QString &err) {
+
+	QWriteLocker lock(&m_cacheLock);
 
-	err = QString::null;
+	// stale if the release information got replaced meanwhile
+	if(!m_pendingBodies.remove(idx)) return;
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+	if(err.isNull()) m_bodies.insert(idx, b);
 
-	QVariant v(QJsonDocument::fromJson(ba, &ok).toVariant());
+	const bool done = m_pendingBodies.isEmpty();
+	const bool all  = done && m_renderingAll;
+
+	if(done) {
+		m_renderingAll = false;
+		m_resources.clear();
+	}
 
-	if(ok.error == QJsonParseError::NoError) {
-		return v;
+	lock.unlock();
+
+	if(err.isNull()) {
+		emit bodyAvailable(idx, b);
 	} else {
-		err = ok.errorString();
+		emit error(err);
 	}
 
-#else
+	if(all) emit bodiesRendered();
+}
 
-	QVariant v(parser.parse(m_jsonData, &ok));
+void QGitHubReleaseAPIPrivate::requestAvatar(int idx) {
 
-	if(ok) {
-		return v;
-	} else {
-		err = parser.errorString();
+	if(!dataAvailable()) {
+		emit error(m_noDataAvailableError);
+		return;
 	}
 
-#endif
-#else
-	err = tr("No JSon parser found");
-#endif
+	if(entries() <= idx) {
+		emit error(QString(m_outOfBoundsError).arg(entries()).arg(idx));
+		return;
+	}
+
+	QWriteLocker lock(&m_cacheLock);
+
+	if(m_avatars.contains(idx)) {
 
-	return QVariant();
+		const QImage img(m_avatars.value(idx));
+
+		lock.unlock();
+		emit avatarAvailable(idx, img);
+
+	} else if(!m_pendingAvatars.contains(idx)) {
+
+		m_pendingAvatars.insert(idx);
+		lock.unlock();
+
+		JobNotifier *n = new JobNotifier();
+
+		QObject::connect(n, SIGNAL(avatarDecoded(int,QImage)),
+						 this, SLOT(avatarDecoded(int,QImage)));
+
+		QThreadPool::globalInstance()->start(new AvatarJob(n, idx, avatarUrl(idx), m_userAgent));
+	}
 }
 
-void QGitHubReleaseAPIPrivate::downloaded(const FileDownloader &fd) {
+void QGitHubReleaseAPIPrivate::avatarDecoded(int idx, const QImage &img) {
 
-	QObject::connect(m_apiDownloader, SIGNAL(error(QString)), this, SLOT(fdError(QString)));
-	QObject::connect(m_apiDownloader, SIGNAL(downloaded(FileDownloader)),
-					 this, SLOT(downloaded(FileDownloader)));
-	QObject::connect(m_apiDownloader, SIGNAL(progress(qint64,qint64)),
-					 this, SLOT(downloadProgress(qint64,qint64)));
+	QWriteLocker lock(&m_cacheLock);
 
-	m_jsonData = fd.downloadedData();
+	if(!m_pendingAvatars.remove(idx)) return;
 
-	foreach(const FileDownloader::RAWHEADERPAIR &pair, fd.rawHeaderPairs()) {
+	if(!img.isNull()) {
+		m_avatars.insert(idx, img);
+		lock.unlock();
+		emit avatarAvailable(idx, img);
+	} else {
+		lock.unlock();
+		emit error(tr("Avatar %1 not available").arg(idx));
+	}
+}
+
+void QGitHubReleaseAPIPrivate::downloadProgress(qint64 br, qint64 bt) {
+	emit progress(br, bt);
+}
 
-		if(pair.first == "ETag") m_eTag = pair.second.mid(2);
+void QGitHubReleaseAPIPrivate::apiFinished(const QByteArray &json, const QVariant &va,
+										   const QString &err, int httpStatus,
+										   const FileDownloader::RAWHEADERPAIRLIST &headers) {
+
+	foreach(const FileDownloader::RAWHEADERPAIR &pair, headers) {
+
+		if(pair.first == "ETag") {
+			m_eTag = pair.second.startsWith("W/") ? pair.second.mid(2) : pair.second;
+		}
 
 		if(pair.first == "X-RateLimit-Reset") {
 			m_rateLimitReset = QDateTime::fromTime_t(QString(pair.second).toUInt());
@@ -426,11 +572,48 @@ void QGitHubReleaseAPIPrivate::downloaded(const FileDownloader &fd) {
 		}
 	}
 
-	QVariant va(parseJSon(m_jsonData, m_errorString));
+	if(httpStatus == 304) {
 
-	if(m_errorString.isNull()) {
+		if(dataAvailable()) {
+			emit notModified();
+		} else {
+			emit error(m_noDataAvailableError);
+		}
+
+		return;
+	}
+
+	m_jsonData = json;
+	m_queryIndex.invalidate();
+
+	m_cacheLock.lockForWrite();
+	m_bodies.clear();
+	m_avatars.clear();
+	m_pendingBodies.clear();
+	m_pendingAvatars.clear();
+	m_renderingAll = false;
+	m_resources.clear();
+	m_cacheLock.unlock();
+
+	m_store.clear();
+	m_jsonIndex.clear();
 
-		if(m_singleEntryRequested) {
+	if((m_errorString = err).isNull()) {
+
+		if(va.userType() == qMetaTypeId<QSharedPointer<JsonIndex> >()) {
+
+			m_vdata.clear();
+			m_jsonIndex = va.value<QSharedPointer<JsonIndex> >();
+
+			if(!m_singleEntryRequested && (!m_jsonIndex->isArray() || !m_jsonIndex->entries())) {
+				m_errorString = m_jsonIndex->toVariant().toMap()["message"].toString();
+				m_jsonIndex.clear();
+				emit error(m_errorString);
+				return;
+			}
+
+		} else if(m_singleEntryRequested) {
+			m_vdata.clear();
 			m_vdata.append(va);
 		} else if((m_vdata = va.toList()).isEmpty()) {
 			m_errorString = va.toMap()["message"].toString();
@@ -438,6 +621,8 @@ void QGitHubReleaseAPIPrivate::downloaded(const FileDownloader &fd) {
 			return;
 		}
 
+		parseVersions();
+
 		emit available();
 
 	} else {
@@ -445,16 +630,229 @@ void QGitHubReleaseAPIPrivate::downloaded(const FileDownloader &fd) {
 	}
 }
 
+void QGitHubReleaseAPIPrivate::refresh() {
+
+	if(!m_apiWorker->url().isValid()) {
+		emit error(m_noDataAvailableError);
+		return;
+	}
+
+	QMetaObject::invokeMethod(m_apiWorker, "start", Q_ARG(int, m_type),
+							  Q_ARG(QString, dataAvailable() ? m_eTag : QString::null));
+}
+
+bool QGitHubReleaseAPIPrivate::saveSnapshot(QFile &of) const {
+
+	if(!dataAvailable()) {
+		emit error(m_noDataAvailableError);
+		return false;
+	}
+
+	if(!of.isOpen() && !of.open(QFile::WriteOnly|QFile::Truncate)) {
+		emit error(of.errorString());
+		return false;
+	}
+
+	QDataStream out(&of);
+
+	out << m_snapshotMagic << m_snapshotVersion;
+
+	out.setVersion(QDataStream::Qt_4_6);
+
+	QReadLocker lock(&m_cacheLock);
+
+	out << apiUrl() << static_cast<qint32>(m_type) << m_singleEntryRequested << m_eTag
+		<< m_rateLimit << m_rateLimitRemaining << m_rateLimitReset << toVariantList()
+		<< m_bodies << m_avatars;
+
+	if(out.status() != QDataStream::Ok || !of.flush()) {
+		emit error(of.errorString());
+		return false;
+	}
+
+	return true;
+}
+
+bool QGitHubReleaseAPIPrivate::saveIndex(QFile &of) const {
+
+	if(!dataAvailable()) {
+		emit error(m_noDataAvailableError);
+		return false;
+	}
+
+	if(!of.isOpen() && !of.open(QFile::WriteOnly|QFile::Truncate)) {
+		emit error(of.errorString());
+		return false;
+	}
+
+	if(!(ReleaseStore::write(of, toVariantList(), apiUrl(), m_eTag, m_type,
+							 m_singleEntryRequested) && of.flush())) {
+		emit error(of.errorString());
+		return false;
+	}
+
+	return true;
+}
+
+bool QGitHubReleaseAPIPrivate::loadSnapshot(QFile &f, QUrl &url) {
+
+	if(!f.isOpen() && !f.open(QFile::ReadOnly)) {
+		m_errorString = f.errorString();
+		return false;
+	}
+
+	uchar *map = f.map(f.pos(), f.size() - f.pos());
+
+	QByteArray ba(map ? QByteArray::fromRawData(reinterpret_cast<const char *>(map),
+												static_cast<int>(f.size() - f.pos())) :
+						f.readAll());
+	QDataStream in(ba);
+
+	quint32 magic = 0;
+	quint16 version = 0;
+	qint32 type = QGitHubReleaseAPI::RAW;
+
+	in >> magic >> version;
+
+	if(magic != m_snapshotMagic) {
+		m_errorString = tr("%1: not a release snapshot").arg(f.fileName());
+	} else if(version > m_snapshotVersion) {
+		m_errorString = tr("%1: unsupported snapshot version %2").arg(f.fileName()).arg(version);
+	} else {
+
+		in.setVersion(QDataStream::Qt_4_6);
+
+		in >> url >> type >> m_singleEntryRequested >> m_eTag >> m_rateLimit
+		   >> m_rateLimitRemaining >> m_rateLimitReset >> m_vdata >> m_bodies >> m_avatars;
+
+		m_type = static_cast<QGitHubReleaseAPI::TYPE>(type);
+
+		if(in.status() != QDataStream::Ok) {
+			m_errorString = tr("%1: corrupt snapshot").arg(f.fileName());
+		}
+	}
+
+	if(map) f.unmap(map);
+
+	return m_errorString.isNull();
+}
+
+void QGitHubReleaseAPIPrivate::snapshotLoaded() {
+
+	if(m_errorString.isNull()) {
+		emit available();
+	} else {
+		emit error(m_errorString);
+	}
+}
+
 bool QGitHubReleaseAPIPrivate::dataAvailable() const {
-	return !m_vdata.isEmpty();
+
+	if(m_jsonIndex) return m_jsonIndex->entries() > 0;
+
+	return m_store ? m_store->entries() > 0 : !m_vdata.isEmpty();
+}
+
+QVariant QGitHubReleaseAPIPrivate::value(int idx, const QString &id, const QString &subId) const {
+
+	if(m_store) return m_store->value(idx, id, subId);
+	if(m_jsonIndex) return m_jsonIndex->value(idx, id, subId);
+
+	return subId.isEmpty() ? m_vdata[idx].toMap()[id] : m_vdata[idx].toMap()[subId].toMap()[id];
+}
+
+QVariantList QGitHubReleaseAPIPrivate::toVariantList() const {
+
+	if(m_jsonIndex) {
+
+		const QVariant &v(m_jsonIndex->toVariant());
+
+		return m_jsonIndex->isArray() ? v.toList() : QVariantList() << v;
+	}
+
+	return m_store ? m_store->toVariantList() : m_vdata;
+}
+
+QGitHubReleaseSnapshot QGitHubReleaseAPIPrivate::snapshot() const {
+
+	if(!dataAvailable()) return QGitHubReleaseSnapshot();
+
+	return QGitHubReleaseSnapshot(new ReleaseData(apiUrl(), m_eTag, m_type, m_vdata, m_jsonIndex,
+												  m_store));
 }
 
 QUrl QGitHubReleaseAPIPrivate::apiUrl() const {
-	return m_apiDownloader->url();
+	return m_apiWorker->url();
 }
 
 int QGitHubReleaseAPIPrivate::entries() const {
-	return dataAvailable() ? m_vdata.count() : 0;
+	if(m_jsonIndex) return m_jsonIndex->entries();
+
+	return dataAvailable() ? (m_store ? m_store->entries() : m_vdata.count()) : 0;
+}
+
+int QGitHubReleaseAPIPrivate::indexOfTag(const QString &tag) const {
+	return m_queryIndex.indexOfTag(*this, tag);
+}
+
+int QGitHubReleaseAPIPrivate::indexOfId(ulong id) const {
+	return m_queryIndex.indexOfId(*this, id);
+}
+
+QList<int> QGitHubReleaseAPIPrivate::releasesBetween(const QDateTime &from,
+													 const QDateTime &to) const {
+	return m_queryIndex.between(*this, from, to);
+}
+
+int QGitHubReleaseAPIPrivate::indexOfNewestRelease() const {
+	return m_queryIndex.newestRelease(*this);
+}
+
+void QGitHubReleaseAPIPrivate::parseVersions() {
+
+	const int n = entries();
+
+	m_versions.resize(n);
+	m_versionOrder.clear();
+
+	for(int i = 0; i < n; ++i) {
+		m_versions[i] = Version(tagName(i));
+		m_versionOrder.append(i);
+	}
+
+	qStableSort(m_versionOrder.begin(), m_versionOrder.end(), VersionGreater(m_versions));
+}
+
+QList<int> QGitHubReleaseAPIPrivate::newerThan(const QString &version, bool preReleases,
+											   bool drafts) const {
+
+	const Version ref(version);
+
+	int lo = 0, hi = m_versionOrder.count();
+
+	// m_versionOrder is sorted descending, find the first entry not newer than ref
+	while(lo < hi) {
+
+		const int mid = (lo + hi) / 2;
+		const Version &v(m_versions[m_versionOrder[mid]]);
+
+		if(v.isValid() && ref < v) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	QList<int> l;
+
+	for(int i = 0; i < lo; ++i) {
+
+		const int idx = m_versionOrder[i];
+
+		if((preReleases || !isPreRelease(idx)) && (drafts || !isDraft(idx))) l.append(idx);
+	}
+
+	return l;
 }
 
 QByteArray QGitHubReleaseAPIPrivate::tarBall(int idx) const {
@@ -473,15 +871,41 @@ qint64 QGitHubReleaseAPIPrivate::zipBall(QFile &of, int idx) const {
 	return fileToFileDownload<&QGitHubReleaseAPIPrivate::zipBallUrl>(&of, idx);;
 }
 
-void QGitHubReleaseAPIPrivate::cancel() {
+qint64 QGitHubReleaseAPIPrivate::extractTarBall(const QString &dir, const QStringList &filters,
+												int idx) const {
+	return extract(tarBallUrl(idx), ArchiveExtractor::TARGZ, dir, filters);
+}
 
-#if QT_VERSION >= QT_VERSION_CHECK(4, 5, 0)
-	if(m_readReply && m_readReply->isRunning()) {
-#else
-	if(m_readReply) {
-#endif
-		m_readReply->abort();
+qint64 QGitHubReleaseAPIPrivate::extractZipBall(const QString &dir, const QStringList &filters,
+												int idx) const {
+	return extract(zipBallUrl(idx), ArchiveExtractor::ZIP, dir, filters);
+}
+
+qint64 QGitHubReleaseAPIPrivate::extract(const QUrl &url, ArchiveExtractor::FORMAT format,
+										 const QString &dir, const QStringList &filters) const {
+
+	ArchiveExtractor x(format, dir, filters);
+
+	if(!x.open(QIODevice::WriteOnly)) {
+		emit error(x.errorString());
+		return Q_INT64_C(-1);
 	}
+
+	qint64 r = downloadFile(url, &x);
+
+	if(r != Q_INT64_C(-1) && !x.finish()) r = Q_INT64_C(-1);
+
+	if(x.hasFailed()) emit error(x.errorString());
+
+	return r;
+}
+
+void QGitHubReleaseAPIPrivate::cancel() {
+
+	QMutexLocker lock(&m_downloadsMutex);
+
+	// queued if the download runs in another thread
+	foreach(DownloadContext *ctx, m_downloads) QMetaObject::invokeMethod(ctx, "abort");
 }
 
 QUrl QGitHubReleaseAPIPrivate::releaseUrl(int idx) const {
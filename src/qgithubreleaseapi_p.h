@@ -20,12 +20,23 @@
 #ifndef QGITHUBRELEASEAPI_P_H
 #define QGITHUBRELEASEAPI_P_H
 
+#include <QSet>
 #include <QFile>
-
-#include "qgithubreleaseapi.h"
-
-QT_FORWARD_DECLARE_CLASS(QNetworkReply)
-QT_FORWARD_DECLARE_CLASS(FileDownloader)
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+
+#include "filedownloader.h"
+#include "queryindex.h"
+#include "version.h"
+#include "qgithubreleasesnapshot.h"
+#include "archiveextractor.h"
+
+QT_FORWARD_DECLARE_CLASS(ApiWorker)
+QT_FORWARD_DECLARE_CLASS(DownloadContext)
+QT_FORWARD_DECLARE_CLASS(ResourceCache)
+QT_FORWARD_DECLARE_CLASS(JsonIndex)
+QT_FORWARD_DECLARE_CLASS(ReleaseStore)
 
 class Q_DECL_HIDDEN QGitHubReleaseAPIPrivate : public QObject {
 	Q_OBJECT
@@ -44,6 +55,7 @@ public:
 							 QGitHubReleaseAPI::TYPE type, QObject *parent = 0);
 	QGitHubReleaseAPIPrivate(const QString &user, const QString &repo, int limit,
 							 QGitHubReleaseAPI::TYPE type, QObject *parent = 0);
+	explicit QGitHubReleaseAPIPrivate(QFile &snapshot, QObject *parent = 0);
 
 	virtual ~QGitHubReleaseAPIPrivate();
 
@@ -51,8 +63,34 @@ public:
 		m_userAgent = ua;
 	}
 
-	QByteArray downloadFile(const QUrl &u, bool generic = false) const;
-	qint64 downloadFile(const QUrl &u, QIODevice *of, bool generic = false) const;
+	inline static const char *userAgent() {
+		return m_userAgent;
+	}
+
+	inline static void setWorkerThreadEnabled(bool b) {
+		m_workerThreadEnabled = b;
+	}
+
+	static void setLazyParsingEnabled(bool b);
+
+	static void setApiBaseUrl(const QUrl &url);
+	static QUrl apiBaseUrl();
+
+	/// an URL below @c baseUrl or the global API base URL, @c path has to start with a slash
+	static QUrl apiEndpoint(const QString &path, const QUrl &baseUrl = QUrl());
+
+	static QUrl releasesApiUrl(const QString &user, const QString &repo, int perPage,
+							   const QUrl &baseUrl = QUrl());
+	static QUrl latestReleaseApiUrl(const QString &user, const QString &repo,
+									const QUrl &baseUrl = QUrl());
+	static QUrl tagReleaseApiUrl(const QString &user, const QString &repo, const QString &tag,
+								 const QUrl &baseUrl = QUrl());
+
+	QByteArray downloadFile(const QUrl &u, bool generic = false,
+							FileDownloader::PRIORITY priority = FileDownloader::LOW) const;
+	qint64 downloadFile(const QUrl &u, QIODevice *of, bool generic = false,
+						FileDownloader::PRIORITY priority = FileDownloader::LOW) const;
+	qint64 downloadFile(const QUrl &u, QFile &of) const;
 
 	QUrl apiUrl() const;
 	int entries() const;
@@ -82,13 +120,33 @@ public:
 	QByteArray zipBall(int idx) const;
 	qint64 zipBall(QFile &of, int idx) const;
 
+	qint64 extractTarBall(const QString &dir, const QStringList &filters, int idx) const;
+	qint64 extractZipBall(const QString &dir, const QStringList &filters, int idx) const;
+
 	QString body(int idx) const;
 	QImage avatar(int idx) const;
 
-	inline QVariantList toVariantList() const {
-		return m_vdata;
+	void requestBody(int idx);
+	void requestAvatar(int idx);
+	void renderAllBodies();
+
+	int indexOfTag(const QString &tag) const;
+	int indexOfId(ulong id) const;
+	QList<int> releasesBetween(const QDateTime &from, const QDateTime &to) const;
+	int indexOfNewestRelease() const;
+
+	inline QList<int> sortedByVersion() const {
+		return m_versionOrder;
 	}
 
+	QList<int> newerThan(const QString &version, bool preReleases, bool drafts) const;
+
+	bool saveSnapshot(QFile &of) const;
+	bool saveIndex(QFile &of) const;
+
+	QVariantList toVariantList() const;
+	QGitHubReleaseSnapshot snapshot() const;
+
 	inline QByteArray asJsonData() const {
 		return m_jsonData;
 	}
@@ -115,51 +173,54 @@ public:
 
 public slots:
 	void cancel();
+	void refresh();
 
 private slots:
-	void readChunk();
-	void updateReply(QNetworkReply *);
-	void downloaded(const FileDownloader &);
+	void apiFinished(const QByteArray &json, const QVariant &data, const QString &err,
+					 int httpStatus, const FileDownloader::RAWHEADERPAIRLIST &headers);
+	void bodyRendered(int idx, const QString &body, const QString &err);
+	void avatarDecoded(int idx, const QImage &avatar);
 	void fdError(const QString &);
 	void fdCanceled();
 	void fileDownloadError(const QString &);
 	void downloadProgress(qint64, qint64);
 	void fileDownloadProgress(qint64, qint64);
+	void snapshotLoaded();
 
 signals:
 	void available();
+	void notModified();
+	void bodyAvailable(int idx, const QString &body);
+	void bodiesRendered();
+	void avatarAvailable(int idx, const QImage &avatar);
 	void canceled();
 	void error(const QString &) const;
 	void progress(qint64, qint64);
 
 private:
-	void init() const;
-	QVariant parseJSon(const QByteArray &ba, QString &err) const;
-	QString embedImages(QString &b) const;
+	void init(bool start = true) const;
 	bool dataAvailable() const;
+	QVariant value(int idx, const QString &id, const QString &subId = QString::null) const;
+	bool loadSnapshot(QFile &f, QUrl &apiUrl);
+	void parseVersions();
+	void startBodyJob(int idx);
+	qint64 extract(const QUrl &url, ArchiveExtractor::FORMAT format, const QString &dir,
+				   const QStringList &filters) const;
 
 	template<QUrl (QGitHubReleaseAPIPrivate::*T)(int) const>
 	qint64 fileToFileDownload(QFile *of, int idx) const {
-
-		int ok = 0;
-
-		if(of && !of->isOpen()) ok = of->open(QFile::WriteOnly);
-
-		if(ok) {
-			return downloadFile((this->*T)(idx), of);
-		} else if(of) {
-			emit error(of->errorString());
-		}
-
-		return ok;
+		return of ? downloadFile((this->*T)(idx), *of) : Q_INT64_C(-1);
 	}
 
 private:
 	static const char *m_userAgent;
+	static bool m_workerThreadEnabled;
 	static const char *m_outOfBoundsError;
 	static const char *m_noDataAvailableError;
+	static const quint32 m_snapshotMagic;
+	static const quint16 m_snapshotVersion;
 
-	const FileDownloader *m_apiDownloader;
+	ApiWorker *m_apiWorker;
 	QByteArray m_jsonData;
 	QVariantList m_vdata;
 	QString m_errorString;
@@ -168,12 +229,21 @@ private:
 	bool m_singleEntryRequested;
 	QDateTime m_rateLimitReset;
 	mutable QMap<int, QImage> m_avatars;
+	mutable QMap<int, QString> m_bodies;
 	QString m_eTag;
-	mutable QIODevice *m_dlOutputFile;
-	mutable qint64 m_readBytes;
-	mutable QNetworkReply *m_readReply;
-	mutable qint64 m_bytesAvail;
 	QGitHubReleaseAPI::TYPE m_type;
+	QSharedPointer<const ReleaseStore> m_store;
+	QSharedPointer<JsonIndex> m_jsonIndex;
+	mutable QueryIndex m_queryIndex;
+	QVector<Version> m_versions;
+	QList<int> m_versionOrder;
+	QSet<int> m_pendingBodies;
+	QSet<int> m_pendingAvatars;
+	bool m_renderingAll;
+	QSharedPointer<ResourceCache> m_resources;
+	mutable QReadWriteLock m_cacheLock;
+	mutable QSet<DownloadContext *> m_downloads;
+	mutable QMutex m_downloadsMutex;
 };
 
 #endif // QGITHUBRELEASEAPI_P_H
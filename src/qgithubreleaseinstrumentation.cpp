@@ -0,0 +1,128 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qgithubreleaseinstrumentation.h"
+
+namespace {
+
+class Instance : public QGitHubReleaseInstrumentation {
+public:
+	Instance() : QGitHubReleaseInstrumentation() {}
+};
+
+}
+
+Q_GLOBAL_STATIC(Instance, globalInstance)
+
+QGitHubReleaseRequestStats::QGitHubReleaseRequestStats() : url(), httpStatus(0), failed(false),
+	dnsTime(Q_INT64_C(-1)), connectTime(Q_INT64_C(-1)), tlsTime(Q_INT64_C(-1)),
+	ttfb(Q_INT64_C(-1)), totalTime(Q_INT64_C(-1)), bytesReceived(Q_INT64_C(0)),
+	fromCache(false), notModified(false), redirects(0), retries(0), hedged(false),
+	timedOut(false), http2(false), coalesced(false), rateLimit(-1), rateLimitRemaining(-1),
+	rateLimitReset() {}
+
+QGitHubReleaseInstrumentation::Snapshot::Snapshot() : requests(Q_INT64_C(0)),
+	failed(Q_INT64_C(0)), bytesReceived(Q_INT64_C(0)), fromCache(Q_INT64_C(0)),
+	notModified(Q_INT64_C(0)), redirects(Q_INT64_C(0)), retries(Q_INT64_C(0)),
+	hedged(Q_INT64_C(0)), timeouts(Q_INT64_C(0)), http2(Q_INT64_C(0)), coalesced(Q_INT64_C(0)),
+	ttfb(Q_INT64_C(0)), ttfbCount(Q_INT64_C(0)), totalTime(Q_INT64_C(0)), rateLimit(-1),
+	rateLimitRemaining(-1), rateLimitReset() {
+
+	for(int i = 0; i < PHASES; ++i) phaseCount[i] = phaseTime[i] = Q_INT64_C(0);
+}
+
+QGitHubReleaseInstrumentation::QGitHubReleaseInstrumentation() : QObject(), m_mutex(),
+	m_snapshot(), m_callback(0L), m_userData(0L) {
+	qRegisterMetaType<QGitHubReleaseRequestStats>("QGitHubReleaseRequestStats");
+}
+
+QGitHubReleaseInstrumentation::~QGitHubReleaseInstrumentation() {}
+
+QGitHubReleaseInstrumentation *QGitHubReleaseInstrumentation::instance() {
+	return globalInstance();
+}
+
+QGitHubReleaseInstrumentation::Snapshot QGitHubReleaseInstrumentation::snapshot() const {
+	QMutexLocker lock(&m_mutex);
+	return m_snapshot;
+}
+
+void QGitHubReleaseInstrumentation::setCallback(REQUESTCALLBACK cb, void *userData) {
+	QMutexLocker lock(&m_mutex);
+	m_callback = cb;
+	m_userData = userData;
+}
+
+void QGitHubReleaseInstrumentation::reset() {
+	QMutexLocker lock(&m_mutex);
+	m_snapshot = Snapshot();
+}
+
+void QGitHubReleaseInstrumentation::record(const QGitHubReleaseRequestStats &s) {
+
+	m_mutex.lock();
+
+	++m_snapshot.requests;
+
+	if(s.failed) ++m_snapshot.failed;
+	if(s.fromCache) ++m_snapshot.fromCache;
+	if(s.notModified) ++m_snapshot.notModified;
+
+	m_snapshot.bytesReceived += s.bytesReceived;
+	m_snapshot.redirects += s.redirects;
+	m_snapshot.retries += s.retries;
+
+	if(s.hedged) ++m_snapshot.hedged;
+	if(s.timedOut) ++m_snapshot.timeouts;
+	if(s.http2) ++m_snapshot.http2;
+	if(s.coalesced) ++m_snapshot.coalesced;
+
+	// failed requests may not have received any response
+	if(s.ttfb >= 0) {
+		m_snapshot.ttfb += s.ttfb;
+		++m_snapshot.ttfbCount;
+	}
+
+	if(s.totalTime > 0) m_snapshot.totalTime += s.totalTime;
+
+	if(s.rateLimit != -1) {
+		m_snapshot.rateLimit = s.rateLimit;
+		m_snapshot.rateLimitRemaining = s.rateLimitRemaining;
+		m_snapshot.rateLimitReset = s.rateLimitReset;
+	}
+
+	const REQUESTCALLBACK cb = m_callback;
+	void *const userData = m_userData;
+
+	m_mutex.unlock();
+
+	if(cb) cb(s, userData);
+
+	emit requestFinished(s);
+}
+
+void QGitHubReleaseInstrumentation::recordPhase(PHASE phase, qint64 nsecs) {
+
+	m_mutex.lock();
+	++m_snapshot.phaseCount[phase];
+	m_snapshot.phaseTime[phase] += nsecs;
+	m_mutex.unlock();
+
+	emit phaseFinished(phase, nsecs);
+}
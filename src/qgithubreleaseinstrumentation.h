@@ -0,0 +1,184 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef QGITHUBRELEASEINSTRUMENTATION_H
+#define QGITHUBRELEASEINSTRUMENTATION_H
+
+#include <QMutex>
+#include <QMetaType>
+
+#include "qgithubreleaseapi.h"
+
+QT_FORWARD_DECLARE_CLASS(FileDownloader)
+QT_FORWARD_DECLARE_CLASS(ApiWorker)
+QT_FORWARD_DECLARE_CLASS(BodyRenderer)
+
+/**
+ * @brief Measurements of a single request
+ *
+ * All times are in milliseconds since the request was started, @c -1 if not
+ * measurable. The phases of connection setup (DNS lookup, TCP connect) are not
+ * exposed by @c QNetworkAccessManager and thus always @c -1.
+ */
+struct Q_DECL_EXPORT QGitHubReleaseRequestStats {
+	QGitHubReleaseRequestStats();
+
+	QUrl url; ///< the requested URL
+	int httpStatus; ///< the HTTP status code, @c 0 if no response was received
+	bool failed; ///< @c true if the request failed or got canceled
+	qint64 dnsTime; ///< time until the host name was resolved
+	qint64 connectTime; ///< time until the connection was established
+	qint64 tlsTime; ///< time until the TLS handshake was finished (Qt 5.1 and newer)
+	qint64 ttfb; ///< time until the response headers were received
+	qint64 totalTime; ///< time until the request was finished
+	qint64 bytesReceived; ///< number of body bytes received
+	bool fromCache; ///< @c true if the response was served from the cache
+	bool notModified; ///< @c true if the response was a @em 304
+	int redirects; ///< number of redirects followed
+	int retries; ///< number of retries
+	bool hedged; ///< @c true if a duplicate request was issued
+	bool timedOut; ///< @c true if the last attempt timed out
+	bool http2; ///< @c true if the response was received via HTTP/2 (Qt 5.8 and newer)
+	bool coalesced; ///< @c true if the response was shared by an identical request in flight
+	int rateLimit; ///< the rate limit reported by the server, @c -1 if none
+	int rateLimitRemaining; ///< the remaining rate limit, @c -1 if none
+	QDateTime rateLimitReset; ///< the date the rate limit resets
+};
+
+Q_DECLARE_METATYPE(QGitHubReleaseRequestStats)
+
+/**
+ * @brief The @c %QGitHubReleaseInstrumentation class
+ *
+ * Collects measurements of every request made and every processing phase run
+ * by the library, in any thread. They are reported by signals, by an optional
+ * callback and accumulated into a snapshot.
+ *
+ * @author Heiko Schaefer
+ */
+class Q_DECL_EXPORT QGitHubReleaseInstrumentation : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(QGitHubReleaseInstrumentation)
+
+	friend class FileDownloader;
+	friend class ApiWorker;
+	friend class BodyRenderer;
+
+public:
+	/**
+	 * @brief Processing phases
+	 */
+	typedef enum { PARSE, ///< parsing the JSon release information
+				   MARKDOWN, ///< rendering a markdown body with @em libmarkdown
+				   EMBED_IMAGES, ///< substituting emojis and embedding images into a body
+				   PHASES ///< number of phases
+				 } PHASE;
+
+	/**
+	 * @brief Accumulated measurements
+	 */
+	struct Q_DECL_EXPORT Snapshot {
+		Snapshot();
+
+		qint64 requests; ///< number of requests
+		qint64 failed; ///< number of failed or canceled requests
+		qint64 bytesReceived; ///< number of body bytes received
+		qint64 fromCache; ///< number of responses served from the cache
+		qint64 notModified; ///< number of @em 304 responses
+		qint64 redirects; ///< number of redirects followed
+		qint64 retries; ///< number of retries
+		qint64 hedged; ///< number of requests with a duplicate request issued
+		qint64 timeouts; ///< number of requests failed by a timeout
+		qint64 http2; ///< number of responses received via HTTP/2
+		qint64 coalesced; ///< number of responses shared by an identical request in flight
+		qint64 ttfb; ///< sum of the times to first byte in milliseconds
+		qint64 ttfbCount; ///< number of requests a time to first byte got measured for
+		qint64 totalTime; ///< sum of the request times in milliseconds
+		qint64 phaseCount[PHASES]; ///< number of runs per phase
+		qint64 phaseTime[PHASES]; ///< sum of the run times per phase in nanoseconds
+		int rateLimit; ///< the most recently reported rate limit, @c -1 if none
+		int rateLimitRemaining; ///< the most recently reported remaining rate limit
+		QDateTime rateLimitReset; ///< the most recently reported rate limit reset
+	};
+
+	/**
+	 * @brief Callback invoked synchronously in the thread the request finished in
+	 */
+	typedef void (*REQUESTCALLBACK)(const QGitHubReleaseRequestStats &stats, void *userData);
+
+	/**
+	 * @brief The process wide instance
+	 * @return the process wide instance
+	 */
+	static QGitHubReleaseInstrumentation *instance();
+
+	virtual ~QGitHubReleaseInstrumentation();
+
+	/**
+	 * @brief The measurements accumulated since the start or the last @c reset
+	 * @return the accumulated measurements
+	 */
+	Snapshot snapshot() const;
+
+	/**
+	 * @brief Sets the callback
+	 * @param callback the callback or @c 0L to remove it
+	 * @param userData passed to the callback
+	 */
+	void setCallback(REQUESTCALLBACK callback, void *userData = 0L);
+
+public slots:
+	/**
+	 * @brief Clears the accumulated measurements
+	 */
+	void reset();
+
+signals:
+	/**
+	 * @brief Emitted after every request
+	 * @param stats the measurements of the request
+	 */
+	void requestFinished(const QGitHubReleaseRequestStats &stats);
+
+	/**
+	 * @brief Emitted after every processing phase
+	 * @param phase the phase (see @c PHASE)
+	 * @param nsecs the run time in nanoseconds
+	 */
+	void phaseFinished(int phase, qint64 nsecs);
+
+protected:
+	QGitHubReleaseInstrumentation();
+
+private:
+	void record(const QGitHubReleaseRequestStats &stats);
+	void recordPhase(PHASE phase, qint64 nsecs);
+
+private:
+	mutable QMutex m_mutex;
+	Snapshot m_snapshot;
+	REQUESTCALLBACK m_callback;
+	void *m_userData;
+};
+
+#endif // QGITHUBRELEASEINSTRUMENTATION_H
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <climits>
+
+#include <QtAlgorithms>
+
+#include "qgithubreleasescheduler.h"
+#include "jitter.h"
+
+namespace {
+const qint64 UNKNOWNCADENCEINTERVAL = Q_INT64_C(3600000);
+const int CADENCEHISTORY = 10;
+const int POLLSPERCADENCE = 10;
+const int MAXBACKOFF = 16;
+}
+
+QGitHubReleaseScheduler::QGitHubReleaseScheduler(QObject *p) : QObject(p), m_repositories(),
+	m_timer(), m_minInterval(60000), m_maxInterval(86400000), m_rateLimitRemaining(0),
+	m_rateLimitReset() {
+
+	m_timer.setSingleShot(true);
+
+	QObject::connect(&m_timer, SIGNAL(timeout()), this, SLOT(pollDue()));
+}
+
+QGitHubReleaseScheduler::~QGitHubReleaseScheduler() {}
+
+const QGitHubReleaseWatcher *QGitHubReleaseScheduler::addRepository(const QString &user,
+																	const QString &repo,
+																	QGitHubReleaseAPI::TYPE type) {
+	REPOSITORY r;
+
+	r.watcher = new QGitHubReleaseWatcher(user, repo, type, 30, this);
+	r.cadence = Q_INT64_C(-1);
+	r.backoff = 0;
+
+	QObject::connect(r.watcher, SIGNAL(changed(QGitHubReleaseAPI,QList<int>,QList<int>,
+											   QList<ulong>)),
+					 this, SLOT(watcherChanged(QGitHubReleaseAPI,QList<int>,QList<int>,
+											   QList<ulong>)));
+	QObject::connect(r.watcher, SIGNAL(unchanged(QGitHubReleaseAPI)),
+					 this, SLOT(watcherUnchanged(QGitHubReleaseAPI)));
+	QObject::connect(r.watcher, SIGNAL(error(QString)), this, SLOT(watcherError(QString)));
+
+	m_repositories.append(r);
+
+	return r.watcher;
+}
+
+void QGitHubReleaseScheduler::removeRepository(const QGitHubReleaseWatcher *watcher) {
+
+	for(int i = 0; i < m_repositories.count(); ++i) {
+
+		if(m_repositories[i].watcher == watcher) {
+			m_repositories[i].watcher->deleteLater();
+			m_repositories.removeAt(i);
+			break;
+		}
+	}
+
+	scheduleTimer();
+}
+
+QDateTime QGitHubReleaseScheduler::nextPoll(const QGitHubReleaseWatcher *watcher) const {
+
+	foreach(const REPOSITORY &r, m_repositories) {
+		if(r.watcher == watcher) return r.next;
+	}
+
+	return QDateTime();
+}
+
+int QGitHubReleaseScheduler::minimumInterval() const {
+	return m_minInterval;
+}
+
+void QGitHubReleaseScheduler::setMinimumInterval(int msec) {
+	m_minInterval = qMax(1000, msec);
+}
+
+int QGitHubReleaseScheduler::maximumInterval() const {
+	return m_maxInterval;
+}
+
+void QGitHubReleaseScheduler::setMaximumInterval(int msec) {
+	m_maxInterval = qMax(m_minInterval, msec);
+}
+
+QGitHubReleaseScheduler::REPOSITORY *QGitHubReleaseScheduler::repository(const QObject *w) {
+
+	for(int i = 0; i < m_repositories.count(); ++i) {
+		if(m_repositories[i].watcher == w) return &m_repositories[i];
+	}
+
+	return 0L;
+}
+
+void QGitHubReleaseScheduler::learnCadence(REPOSITORY &r) const {
+
+	const QGitHubReleaseAPI &api(r.watcher->api());
+
+	QList<QDateTime> dates;
+
+	for(int i = 0; i < api.entries(); ++i) {
+
+		const QDateTime &published(api.publishedAt(i));
+		const QDateTime &d(published.isValid() ? published : api.createdAt(i));
+
+		if(d.isValid()) dates.append(d);
+	}
+
+	qSort(dates);
+
+	QList<qint64> gaps;
+
+	for(int i = qMax(1, dates.count() - CADENCEHISTORY); i < dates.count(); ++i) {
+		gaps.append(dates[i - 1].msecsTo(dates[i]));
+	}
+
+	qSort(gaps);
+
+	r.lastRelease = dates.isEmpty() ? QDateTime() : dates.last();
+	r.cadence = gaps.isEmpty() ? Q_INT64_C(-1) : qMax(Q_INT64_C(1), gaps[gaps.count() / 2]);
+}
+
+void QGitHubReleaseScheduler::reschedule(REPOSITORY &r, const QGitHubReleaseAPI &api) {
+
+	const QDateTime &now(QDateTime::currentDateTime());
+
+	if(api.rateLimit()) {
+		m_rateLimitRemaining = api.rateLimitRemaining();
+		m_rateLimitReset = api.rateLimitReset();
+	}
+
+	qint64 interval = UNKNOWNCADENCEINTERVAL;
+
+	if(r.cadence > 0) {
+
+		const qint64 silence = r.lastRelease.isValid() ? r.lastRelease.msecsTo(now) : 0;
+
+		// a repository silent for much longer than its cadence has cooled down
+		interval = qMax(r.cadence, silence > 2 * r.cadence ? silence : 0) / POLLSPERCADENCE;
+	}
+
+	interval = qBound(static_cast<qint64>(m_minInterval), interval,
+					  static_cast<qint64>(m_maxInterval));
+
+	for(int i = 0; i < r.backoff && interval < m_maxInterval; ++i) interval *= 2;
+
+	interval = qMin(interval, static_cast<qint64>(m_maxInterval));
+
+	// spread all polls over the rate limit remaining until its reset
+	if(m_rateLimitReset.isValid()) {
+
+		const qint64 untilReset = qMax(Q_INT64_C(0), now.msecsTo(m_rateLimitReset));
+
+		interval = qMax(interval, m_rateLimitRemaining ?
+							untilReset * m_repositories.count() / m_rateLimitRemaining :
+							untilReset);
+	}
+
+	// jitter of +/- 10% keeps repositories from getting polled in lockstep
+	interval += interval / 10 * (Jitter::bounded(201) - 100) / 100;
+
+	r.next = now.addMSecs(interval);
+}
+
+void QGitHubReleaseScheduler::scheduleTimer() {
+
+	QDateTime earliest;
+
+	foreach(const REPOSITORY &r, m_repositories) {
+		if(r.next.isValid() && (!earliest.isValid() || r.next < earliest)) earliest = r.next;
+	}
+
+	if(earliest.isValid()) {
+		m_timer.start(static_cast<int>(qBound(Q_INT64_C(0),
+											  QDateTime::currentDateTime().msecsTo(earliest),
+											  static_cast<qint64>(INT_MAX))));
+	} else {
+		m_timer.stop();
+	}
+}
+
+void QGitHubReleaseScheduler::watcherChanged(const QGitHubReleaseAPI &api,
+											 const QList<int> &added, const QList<int> &modified,
+											 const QList<ulong> &removed) {
+
+	REPOSITORY *r = repository(sender());
+
+	if(r) {
+		learnCadence(*r);
+		r->backoff = 0;
+		reschedule(*r, api);
+		scheduleTimer();
+	}
+
+	emit changed(api, added, modified, removed);
+}
+
+void QGitHubReleaseScheduler::watcherUnchanged(const QGitHubReleaseAPI &api) {
+
+	REPOSITORY *r = repository(sender());
+
+	if(r) {
+		r->backoff = qMin(r->backoff + 1, MAXBACKOFF);
+		reschedule(*r, api);
+		scheduleTimer();
+	}
+}
+
+void QGitHubReleaseScheduler::watcherError(const QString &err) {
+
+	REPOSITORY *r = repository(sender());
+
+	if(r) {
+		r->backoff = qMin(r->backoff + 1, MAXBACKOFF);
+		reschedule(*r, r->watcher->api());
+		scheduleTimer();
+	}
+
+	emit error(err);
+}
+
+void QGitHubReleaseScheduler::pollDue() {
+
+	const QDateTime &now(QDateTime::currentDateTime());
+
+	for(int i = 0; i < m_repositories.count(); ++i) {
+
+		REPOSITORY &r(m_repositories[i]);
+
+		if(r.next.isValid() && !(now < r.next)) {
+			r.next = QDateTime();
+			r.watcher->poll();
+		}
+	}
+
+	scheduleTimer();
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef QGITHUBRELEASESCHEDULER_H
+#define QGITHUBRELEASESCHEDULER_H
+
+#include "qgithubreleasewatcher.h"
+
+/**
+ * @brief The @c %QGitHubReleaseScheduler class
+ *
+ * Polls any number of repositories, each one by a @c QGitHubReleaseWatcher,
+ * at adaptive intervals:
+ *
+ * - the release cadence of a repository is learned from the dates of its
+ *   releases, repositories releasing often are polled more often
+ * - polls finding no changes back off exponentially up to the maximum interval
+ * - all polls together are spread to fit into the rate limit remaining until
+ *   its reset
+ *
+ * @author Heiko Schaefer
+ */
+class Q_DECL_EXPORT QGitHubReleaseScheduler : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(QGitHubReleaseScheduler)
+	Q_PROPERTY(int minimumInterval READ minimumInterval WRITE setMinimumInterval)
+	Q_PROPERTY(int maximumInterval READ maximumInterval WRITE setMaximumInterval)
+
+public:
+	/**
+	 * @brief Creates an @c %QGitHubReleaseScheduler instance
+	 */
+	explicit QGitHubReleaseScheduler(QObject *parent = 0);
+
+	virtual ~QGitHubReleaseScheduler();
+
+	/**
+	 * @brief Adds a repository to poll
+	 * @param user the GitHub user (aka login)
+	 * @param repo the repository to poll
+	 * @param type the type of the body
+	 * @return the watcher polling the repository, owned by the scheduler
+	 */
+	const QGitHubReleaseWatcher *addRepository(const QString &user, const QString &repo,
+											   QGitHubReleaseAPI::TYPE type =
+													   QGitHubReleaseAPI::RAW);
+
+	/**
+	 * @brief Removes a repository
+	 * @param watcher the watcher returned by @c addRepository
+	 */
+	void removeRepository(const QGitHubReleaseWatcher *watcher);
+
+	/**
+	 * @brief The time of the next poll of a repository
+	 * @param watcher the watcher returned by @c addRepository
+	 * @return the time of the next poll or an invalid @c QDateTime if a poll is pending
+	 */
+	QDateTime nextPoll(const QGitHubReleaseWatcher *watcher) const;
+
+	/**
+	 * @brief The minimum interval between two polls of a repository
+	 * @note defaults to one minute
+	 * @return the minimum interval in milliseconds
+	 */
+	int minimumInterval() const;
+
+	/**
+	 * @brief Sets the minimum interval between two polls of a repository
+	 * @param msec the minimum interval in milliseconds
+	 */
+	void setMinimumInterval(int msec);
+
+	/**
+	 * @brief The maximum interval between two polls of a repository
+	 * @note defaults to one day
+	 * @return the maximum interval in milliseconds
+	 */
+	int maximumInterval() const;
+
+	/**
+	 * @brief Sets the maximum interval between two polls of a repository
+	 * @param msec the maximum interval in milliseconds
+	 */
+	void setMaximumInterval(int msec);
+
+signals:
+	/**
+	 * @brief Emitted if the releases of a repository have changed
+	 * @see QGitHubReleaseWatcher::changed
+	 */
+	void changed(const QGitHubReleaseAPI &api, const QList<int> &added,
+				 const QList<int> &modified, const QList<ulong> &removed);
+
+	/**
+	 * @brief Emitted on any error
+	 * @param error the error string
+	 */
+	void error(const QString &error);
+
+private slots:
+	void watcherChanged(const QGitHubReleaseAPI &, const QList<int> &, const QList<int> &,
+						const QList<ulong> &);
+	void watcherUnchanged(const QGitHubReleaseAPI &);
+	void watcherError(const QString &);
+	void pollDue();
+
+private:
+	typedef struct {
+		QGitHubReleaseWatcher *watcher;
+		qint64 cadence;
+		QDateTime lastRelease;
+		int backoff;
+		QDateTime next;
+	} REPOSITORY;
+
+	REPOSITORY *repository(const QObject *watcher);
+	void learnCadence(REPOSITORY &r) const;
+	void reschedule(REPOSITORY &r, const QGitHubReleaseAPI &api);
+	void scheduleTimer();
+
+private:
+	QList<REPOSITORY> m_repositories;
+	QTimer m_timer;
+	int m_minInterval;
+	int m_maxInterval;
+	uint m_rateLimitRemaining;
+	QDateTime m_rateLimitReset;
+};
+
+#endif // QGITHUBRELEASESCHEDULER_H
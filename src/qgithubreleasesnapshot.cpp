@@ -0,0 +1,186 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qgithubreleasesnapshot.h"
+#include "releasedata.h"
+#include "releasestore.h"
+#include "jsonindex.h"
+#include "bodyrenderer.h"
+
+ReleaseData::ReleaseData(const QUrl &url, const QString &tag, QGitHubReleaseAPI::TYPE t,
+						 const QVariantList &data, const QSharedPointer<JsonIndex> &index,
+						 const QSharedPointer<const ReleaseStore> &store) : QSharedData(),
+	apiUrl(url), eTag(tag), type(t), m_vdata(data), m_jsonIndex(index), m_store(store) {}
+
+ReleaseData::~ReleaseData() {}
+
+int ReleaseData::entries() const {
+
+	if(m_store) return m_store->entries();
+	if(m_jsonIndex) return m_jsonIndex->entries();
+
+	return m_vdata.count();
+}
+
+QVariant ReleaseData::value(int idx, const QString &id, const QString &subId) const {
+
+	if(idx < 0 || idx >= entries()) return QVariant();
+
+	if(m_store) return m_store->value(idx, id, subId);
+	if(m_jsonIndex) return m_jsonIndex->value(idx, id, subId);
+
+	return subId.isEmpty() ? m_vdata[idx].toMap()[id] : m_vdata[idx].toMap()[subId].toMap()[id];
+}
+
+QVariantList ReleaseData::toVariantList() const {
+
+	if(m_jsonIndex) {
+
+		const QVariant &v(m_jsonIndex->toVariant());
+
+		return m_jsonIndex->isArray() ? v.toList() : QVariantList() << v;
+	}
+
+	return m_store ? m_store->toVariantList() : m_vdata;
+}
+
+QGitHubReleaseSnapshot::QGitHubReleaseSnapshot() : d() {}
+
+QGitHubReleaseSnapshot::QGitHubReleaseSnapshot(ReleaseData *data) : d(data) {}
+
+QGitHubReleaseSnapshot::QGitHubReleaseSnapshot(const QGitHubReleaseSnapshot &o) : d(o.d) {}
+
+QGitHubReleaseSnapshot::~QGitHubReleaseSnapshot() {}
+
+QGitHubReleaseSnapshot &QGitHubReleaseSnapshot::operator=(const QGitHubReleaseSnapshot &o) {
+	d = o.d;
+	return *this;
+}
+
+template<class T>
+T QGitHubReleaseSnapshot::get(int idx, const char *id, const char *subId) const {
+	return d ? d->value(idx, id, subId ? QString(subId) : QString::null).template value<T>() : T();
+}
+
+#ifdef QJSON_LEGACY_URL_WRAPPER
+template<>
+QUrl QGitHubReleaseSnapshot::get<QUrl>(int idx, const char *id, const char *subId) const {
+	return QUrl(get<QString>(idx, id, subId));
+}
+#endif
+
+bool QGitHubReleaseSnapshot::isNull() const {
+	return !d;
+}
+
+QUrl QGitHubReleaseSnapshot::apiUrl() const {
+	return d ? d->apiUrl : QUrl();
+}
+
+QString QGitHubReleaseSnapshot::eTag() const {
+	return d ? d->eTag : QString::null;
+}
+
+QGitHubReleaseAPI::TYPE QGitHubReleaseSnapshot::type() const {
+	return d ? d->type : QGitHubReleaseAPI::RAW;
+}
+
+int QGitHubReleaseSnapshot::entries() const {
+	return d ? d->entries() : 0;
+}
+
+QVariantList QGitHubReleaseSnapshot::toVariantList() const {
+	return d ? d->toVariantList() : QVariantList();
+}
+
+ulong QGitHubReleaseSnapshot::releaseId(int idx) const {
+	return get<ulong>(idx, "id");
+}
+
+QUrl QGitHubReleaseSnapshot::releaseUrl(int idx) const {
+	return get<QUrl>(idx, "url");
+}
+
+QUrl QGitHubReleaseSnapshot::assetsUrl(int idx) const {
+	return get<QUrl>(idx, "assets_url");
+}
+
+QUrl QGitHubReleaseSnapshot::uploadUrl(int idx) const {
+	return get<QUrl>(idx, "upload_url");
+}
+
+QUrl QGitHubReleaseSnapshot::releaseHtmlUrl(int idx) const {
+	return get<QUrl>(idx, "html_url");
+}
+
+QString QGitHubReleaseSnapshot::name(int idx) const {
+	return get<QString>(idx, "name");
+}
+
+QString QGitHubReleaseSnapshot::body(int idx) const {
+	return get<QString>(idx, BodyRenderer::field(type()));
+}
+
+QString QGitHubReleaseSnapshot::tagName(int idx) const {
+	return get<QString>(idx, "tag_name");
+}
+
+QDateTime QGitHubReleaseSnapshot::publishedAt(int idx) const {
+	return get<QDateTime>(idx, "published_at");
+}
+
+QDateTime QGitHubReleaseSnapshot::createdAt(int idx) const {
+	return get<QDateTime>(idx, "created_at");
+}
+
+QUrl QGitHubReleaseSnapshot::tarBallUrl(int idx) const {
+	return get<QUrl>(idx, "tarball_url");
+}
+
+QUrl QGitHubReleaseSnapshot::zipBallUrl(int idx) const {
+	return get<QUrl>(idx, "zipball_url");
+}
+
+QString QGitHubReleaseSnapshot::targetCommitish(int idx) const {
+	return get<QString>(idx, "target_commitish");
+}
+
+bool QGitHubReleaseSnapshot::isDraft(int idx) const {
+	return get<bool>(idx, "draft");
+}
+
+bool QGitHubReleaseSnapshot::isPreRelease(int idx) const {
+	return get<bool>(idx, "prerelease");
+}
+
+QUrl QGitHubReleaseSnapshot::avatarUrl(int idx) const {
+	return get<QUrl>(idx, "avatar_url", "author");
+}
+
+QUrl QGitHubReleaseSnapshot::authorHtmlUrl(int idx) const {
+	return get<QUrl>(idx, "html_url", "author");
+}
+
+ulong QGitHubReleaseSnapshot::authorId(int idx) const {
+	return get<ulong>(idx, "id", "author");
+}
+
+QString QGitHubReleaseSnapshot::login(int idx) const {
+	return get<QString>(idx, "login", "author");
+}
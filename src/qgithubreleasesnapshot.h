@@ -0,0 +1,135 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef QGITHUBRELEASESNAPSHOT_H
+#define QGITHUBRELEASESNAPSHOT_H
+
+#include <QSharedDataPointer>
+
+#include "qgithubreleaseapi.h"
+
+class ReleaseData;
+
+/**
+ * @brief The @c %QGitHubReleaseSnapshot class
+ *
+ * An immutable, implicitly shared copy of the release information of a
+ * @c QGitHubReleaseAPI. Taking and copying a snapshot costs the same as
+ * copying a @c QString, it stays valid after the @c QGitHubReleaseAPI got
+ * deleted and can be read from any thread concurrently.
+ *
+ * Out of range indices return default constructed values, no error is reported.
+ *
+ * @note the bodies are provided as received, i.e. not rendered
+ * @see QGitHubReleaseAPI::snapshot
+ *
+ * @author Heiko Schaefer
+ */
+class Q_DECL_EXPORT QGitHubReleaseSnapshot {
+	friend class QGitHubReleaseAPIPrivate;
+public:
+	/**
+	 * @brief Creates a null snapshot
+	 */
+	QGitHubReleaseSnapshot();
+	QGitHubReleaseSnapshot(const QGitHubReleaseSnapshot &other);
+	~QGitHubReleaseSnapshot();
+
+	QGitHubReleaseSnapshot &operator=(const QGitHubReleaseSnapshot &other);
+
+	/**
+	 * @brief Checks if the snapshot contains release information
+	 * @return @c true if no release information was available when taken
+	 */
+	bool isNull() const;
+
+	/**
+	 * @brief The api URL the release information was retrieved from
+	 * @return the api URL
+	 */
+	QUrl apiUrl() const;
+
+	/**
+	 * @brief The eTag of the release information
+	 * @return the eTag
+	 */
+	QString eTag() const;
+
+	/**
+	 * @brief The type of the bodies
+	 * @return the type of the bodies
+	 */
+	QGitHubReleaseAPI::TYPE type() const;
+
+	/**
+	 * @brief The number of entries
+	 * @return the number of entries
+	 */
+	int entries() const;
+
+	/**
+	 * @brief Gets the release information as @c QVariantList
+	 * @return the release information
+	 */
+	QVariantList toVariantList() const;
+
+	/**
+	 * @name Accessing the release information
+	 * @{
+	 */
+
+	ulong releaseId(int idx = 0) const;
+	QUrl releaseUrl(int idx = 0) const;
+	QUrl assetsUrl(int idx = 0) const;
+	QUrl uploadUrl(int idx = 0) const;
+	QUrl releaseHtmlUrl(int idx = 0) const;
+	QString name(int idx = 0) const;
+	QString body(int idx = 0) const;
+	QString tagName(int idx = 0) const;
+	QDateTime publishedAt(int idx = 0) const;
+	QDateTime createdAt(int idx = 0) const;
+	QUrl tarBallUrl(int idx = 0) const;
+	QUrl zipBallUrl(int idx = 0) const;
+	QString targetCommitish(int idx = 0) const;
+	bool isDraft(int idx = 0) const;
+	bool isPreRelease(int idx = 0) const;
+	QUrl avatarUrl(int idx = 0) const;
+	QUrl authorHtmlUrl(int idx = 0) const;
+	ulong authorId(int idx = 0) const;
+	QString login(int idx = 0) const;
+
+	/// @}
+
+private:
+	explicit QGitHubReleaseSnapshot(ReleaseData *d);
+
+	template<class T>
+	T get(int idx, const char *id, const char *subId = 0L) const;
+
+private:
+	QSharedDataPointer<ReleaseData> d;
+};
+
+Q_DECLARE_METATYPE(QGitHubReleaseSnapshot)
+
+#endif // QGITHUBRELEASESNAPSHOT_H
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTimer>
+#include <QDateTime>
+#include <QNetworkReply>
+
+#include "qgithubreleaseuploader.h"
+#include "qgithubreleaseapi_p.h"
+#include "filedownloader.h"
+#include "apiworker.h"
+
+struct QGitHubReleaseUploader::Job {
+	Job(int i, const QUrl &u, const QString &f, QIODevice *d, const QString &ct) : id(i), url(u),
+		fileName(f), device(d), contentType(ct.isEmpty() ? "application/octet-stream" : ct),
+		attempt(1), readyAt(Q_INT64_C(0)), canceled(false), timedOut(QString::null),
+		started(Q_INT64_C(0)), lastActivity(Q_INT64_C(0)), sent(Q_INT64_C(0)) {}
+
+	const int id;
+	const QUrl url;
+	const QString fileName; ///< the file to open if uploading a file, else empty
+	QIODevice *device;
+	const QString contentType;
+	int attempt;
+	qint64 readyAt;
+	bool canceled;
+	QString timedOut;
+	qint64 started;
+	qint64 lastActivity;
+	qint64 sent;
+};
+
+QGitHubReleaseUploader::QGitHubReleaseUploader(const QByteArray &token, QObject *p) : QObject(p),
+	m_token(token), m_maxParallel(4), m_nextId(0), m_queue(), m_running(), m_watchdog(this) {
+
+	m_watchdog.setInterval(1000);
+	QObject::connect(&m_watchdog, SIGNAL(timeout()), this, SLOT(watchdog()));
+}
+
+QGitHubReleaseUploader::~QGitHubReleaseUploader() {
+
+	foreach(QNetworkReply *r, m_running.keys()) {
+		r->disconnect(this);
+		r->abort();
+		r->deleteLater();
+	}
+
+	foreach(Job *job, m_queue + m_running.values()) {
+		if(!job->fileName.isEmpty()) delete job->device;
+		delete job;
+	}
+}
+
+QUrl QGitHubReleaseUploader::expandUploadUrl(const QUrl &uploadUrl, const QString &name,
+											 const QString &label) {
+
+	QByteArray t(uploadUrl.toEncoded());
+
+	// the template trails the URL, its braces may arrive percent-encoded
+	int b = t.indexOf('{');
+
+	if(b == -1) b = t.toUpper().indexOf("%7B");
+	if(b != -1) t.truncate(b);
+
+	t.append(t.contains('?') ? '&' : '?').append("name=").append(QUrl::toPercentEncoding(name));
+
+	if(!label.isEmpty()) t.append("&label=").append(QUrl::toPercentEncoding(label));
+
+	return QUrl::fromEncoded(t, QUrl::StrictMode);
+}
+
+int QGitHubReleaseUploader::maxParallel() const {
+	return m_maxParallel;
+}
+
+void QGitHubReleaseUploader::setMaxParallel(int n) {
+	m_maxParallel = qMax(1, n);
+	QTimer::singleShot(0, this, SLOT(schedule()));
+}
+
+int QGitHubReleaseUploader::pending() const {
+	return m_queue.count() + m_running.count();
+}
+
+int QGitHubReleaseUploader::upload(const QUrl &uploadUrl, const QString &fileName,
+								   const QString &name, const QString &label,
+								   const QString &contentType) {
+
+	const QString &n(name.isEmpty() ? QFileInfo(fileName).fileName() : name);
+
+	m_queue.enqueue(new Job(m_nextId, expandUploadUrl(uploadUrl, n, label), fileName, 0L,
+							contentType));
+	QTimer::singleShot(0, this, SLOT(schedule()));
+
+	return m_nextId++;
+}
+
+int QGitHubReleaseUploader::upload(const QUrl &uploadUrl, QIODevice *device, const QString &name,
+								   const QString &label, const QString &contentType) {
+
+	if(!device || !device->isReadable() || device->isSequential()) return -1;
+
+	m_queue.enqueue(new Job(m_nextId, expandUploadUrl(uploadUrl, name, label), QString::null,
+							device, contentType));
+	QTimer::singleShot(0, this, SLOT(schedule()));
+
+	return m_nextId++;
+}
+
+void QGitHubReleaseUploader::cancel(int id) {
+
+	for(int i = 0; i < m_queue.count(); ++i) {
+		if(m_queue[i]->id == id) {
+			done(m_queue.takeAt(i), "Upload canceled");
+			return;
+		}
+	}
+
+	for(QHash<QNetworkReply *, Job *>::const_iterator i(m_running.constBegin());
+			i != m_running.constEnd(); ++i) {
+
+		if(i.value()->id == id) {
+			i.value()->canceled = true;
+			i.key()->abort();
+			return;
+		}
+	}
+}
+
+void QGitHubReleaseUploader::cancelAll() {
+
+	while(!m_queue.isEmpty()) done(m_queue.dequeue(), "Upload canceled");
+
+	foreach(QNetworkReply *r, m_running.keys()) {
+		m_running[r]->canceled = true;
+		r->abort();
+	}
+}
+
+void QGitHubReleaseUploader::schedule() {
+
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+	// jobs waiting for a retry keep their place
+	for(int i = 0; i < m_queue.count() && m_running.count() < m_maxParallel;) {
+		if(m_queue[i]->readyAt > now) {
+			++i;
+		} else {
+			start(m_queue.takeAt(i));
+		}
+	}
+}
+
+bool QGitHubReleaseUploader::start(Job *job) {
+
+	if(!job->device) {
+
+		QFile *f = new QFile(job->fileName);
+
+		if(!f->open(QIODevice::ReadOnly)) {
+			const QString err(f->errorString());
+			delete f;
+			done(job, err);
+			return false;
+		}
+
+		job->device = f;
+	}
+
+	if(!job->device->seek(0)) {
+		done(job, QString("cannot rewind %1").arg(job->url.toString()));
+		return false;
+	}
+
+	QNetworkRequest req(FileDownloader::rewrite(job->url));
+
+	req.setRawHeader("User-Agent", QByteArray(QGitHubReleaseAPIPrivate::userAgent()));
+	req.setRawHeader("Accept", "application/vnd.github.v3+json");
+	req.setRawHeader("Authorization", "token " + m_token);
+	req.setHeader(QNetworkRequest::ContentTypeHeader, job->contentType);
+	req.setHeader(QNetworkRequest::ContentLengthHeader, job->device->size());
+
+	// streamed from the device, Qt reads it as the socket drains
+	QNetworkReply *r = FileDownloader::manager()->post(req, job->device);
+
+	QObject::connect(r, SIGNAL(finished()), this, SLOT(replyFinished()));
+	QObject::connect(r, SIGNAL(uploadProgress(qint64,qint64)),
+					 this, SLOT(uploadProgress(qint64,qint64)));
+
+	job->started = job->lastActivity = QDateTime::currentMSecsSinceEpoch();
+	job->sent = Q_INT64_C(0);
+	job->timedOut = QString::null;
+
+	m_running.insert(r, job);
+
+	if(!m_watchdog.isActive()) m_watchdog.start();
+
+	return true;
+}
+
+void QGitHubReleaseUploader::watchdog() {
+
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	const int ct = FileDownloader::connectTimeout();
+	const int it = FileDownloader::idleTimeout();
+
+	foreach(QNetworkReply *r, m_running.keys()) {
+
+		Job *job = m_running.value(r, 0L);
+
+		// finished meanwhile or timed out already
+		if(!job || !job->timedOut.isNull()) continue;
+
+		if(ct && !job->sent && now - job->started > ct) {
+			job->timedOut = QString("Timeout: no data sent within %1 ms").arg(ct);
+		} else if(it && now - job->lastActivity > it) {
+			job->timedOut = QString("Timeout: no progress within %1 ms").arg(it);
+		} else {
+			continue;
+		}
+
+		// frees the slot, replyFinished decides about a retry
+		r->abort();
+	}
+}
+
+void QGitHubReleaseUploader::uploadProgress(qint64 sent, qint64 total) {
+
+	Job *job = m_running.value(qobject_cast<QNetworkReply *>(sender()), 0L);
+
+	if(!job) return;
+
+	if(sent > job->sent) job->lastActivity = QDateTime::currentMSecsSinceEpoch();
+
+	job->sent = sent;
+
+	emit progress(job->id, sent, total);
+}
+
+void QGitHubReleaseUploader::replyFinished() {
+
+	QNetworkReply *r = qobject_cast<QNetworkReply *>(sender());
+	Job *job = m_running.take(r);
+
+	if(!job) return;
+
+	r->deleteLater();
+
+	if(m_running.isEmpty()) m_watchdog.stop();
+
+	const int status = r->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	QString parseErr;
+	const QVariantMap &v(ApiWorker::parseJSon(r->readAll(), parseErr).toMap());
+	const QString &err(!job->timedOut.isNull() ? job->timedOut : r->errorString());
+
+	// GitHub may have stored a completely sent asset already, a repeated POST would fail
+	const bool retryable = job->sent < job->device->size() &&
+			(!job->timedOut.isNull() || FileDownloader::isTransient(r));
+
+	if(r->error() == QNetworkReply::NoError && status == 201) {
+		done(job, QString::null, v);
+	} else if(!job->canceled && job->attempt < FileDownloader::maxAttempts() && retryable) {
+
+		const int delay = FileDownloader::retryDelay(r, job->attempt++);
+
+		qWarning("Retrying upload to %s: %s", qPrintable(job->url.toString()),
+				 qPrintable(err));
+
+		job->readyAt = QDateTime::currentMSecsSinceEpoch() + delay;
+		m_queue.prepend(job);
+		QTimer::singleShot(delay, this, SLOT(schedule()));
+
+	} else if(job->canceled) {
+		done(job, "Upload canceled");
+	} else {
+		done(job, v.contains("message") ? v["message"].toString() : err);
+	}
+
+	schedule();
+}
+
+void QGitHubReleaseUploader::done(Job *job, const QString &err, const QVariantMap &asset) {
+
+	const int id = job->id;
+
+	if(!job->fileName.isEmpty()) delete job->device;
+
+	delete job;
+
+	if(err.isNull()) {
+		emit uploaded(id, asset);
+	} else {
+		emit error(id, err);
+	}
+
+	if(!pending()) emit finished();
+}
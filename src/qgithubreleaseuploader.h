@@ -0,0 +1,186 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef QGITHUBRELEASEUPLOADER_H
+#define QGITHUBRELEASEUPLOADER_H
+
+#include <QHash>
+#include <QQueue>
+#include <QTimer>
+
+#include "qgithubreleaseapi.h"
+
+QT_FORWARD_DECLARE_CLASS(QIODevice)
+QT_FORWARD_DECLARE_CLASS(QNetworkReply)
+
+/**
+ * @brief The @c %QGitHubReleaseUploader class
+ *
+ * Uploads release assets to the @c QGitHubReleaseAPI::uploadUrl of a release.
+ * The files are streamed from disk, never read into memory as a whole, and
+ * several of them are uploaded in parallel. Uploads failing before their
+ * body was sent completely are retried according to
+ * @c QGitHubReleaseAPI::setRetryPolicy, and time out according to
+ * @c QGitHubReleaseAPI::setTimeouts.
+ *
+ * Uploading requires a token with the @em repo (or @em public_repo) scope.
+ *
+ * @author Heiko Schaefer
+ */
+class Q_DECL_EXPORT QGitHubReleaseUploader : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(QGitHubReleaseUploader)
+	Q_PROPERTY(int maxParallel READ maxParallel WRITE setMaxParallel) ///< the parallel uploads
+
+public:
+	/**
+	 * @brief Creates an @c %QGitHubReleaseUploader instance
+	 * @param token the OAuth or personal access token to authenticate with
+	 */
+	explicit QGitHubReleaseUploader(const QByteArray &token, QObject *parent = 0);
+	virtual ~QGitHubReleaseUploader();
+
+	/**
+	 * @brief Expands the URI template of an upload URL
+	 *
+	 * GitHub reports the upload URL as template like
+	 * @em https://uploads.github.com/repos/o/r/releases/1/assets{?name,label}
+	 *
+	 * @param uploadUrl the upload URL as reported by @c QGitHubReleaseAPI::uploadUrl
+	 * @param name the file name of the asset
+	 * @param label an optional label shown instead of the file name
+	 * @return the expanded URL
+	 */
+	static QUrl expandUploadUrl(const QUrl &uploadUrl, const QString &name,
+								const QString &label = QString::null);
+
+	/**
+	 * @brief The maximum number of parallel uploads
+	 * @note defaults to @c 4
+	 * @return the maximum number of parallel uploads
+	 */
+	int maxParallel() const;
+
+	/**
+	 * @brief Sets the maximum number of parallel uploads
+	 * @param n the maximum number of parallel uploads
+	 */
+	void setMaxParallel(int n);
+
+	/**
+	 * @brief The number of uploads queued or running
+	 * @return the number of uploads queued or running
+	 */
+	int pending() const;
+
+	/**
+	 * @brief Queues the upload of a file
+	 * @param uploadUrl the upload URL as reported by @c QGitHubReleaseAPI::uploadUrl
+	 * @param fileName the file to upload, opened not before its upload starts
+	 * @param name the name of the asset, defaults to the name of the file
+	 * @param label an optional label shown instead of the name
+	 * @param contentType the content type, defaults to @em application/octet-stream
+	 * @return the id of the upload
+	 */
+	int upload(const QUrl &uploadUrl, const QString &fileName, const QString &name = QString::null,
+			   const QString &label = QString::null, const QString &contentType = QString::null);
+
+	/**
+	 * @brief Queues the upload of a device
+	 *
+	 * The device has to be open for reading and must not be sequential, thus its
+	 * size is known and it can get rewound for a retry. It has to stay valid
+	 * until the upload has finished.
+	 *
+	 * @param uploadUrl the upload URL as reported by @c QGitHubReleaseAPI::uploadUrl
+	 * @param device the device to upload
+	 * @param name the name of the asset
+	 * @param label an optional label shown instead of the name
+	 * @param contentType the content type, defaults to @em application/octet-stream
+	 * @return the id of the upload, @c -1 if @c device is not suitable
+	 */
+	int upload(const QUrl &uploadUrl, QIODevice *device, const QString &name,
+			   const QString &label = QString::null, const QString &contentType = QString::null);
+
+public slots:
+	/**
+	 * @brief Cancels an upload
+	 * @param id the id of the upload
+	 */
+	void cancel(int id);
+
+	/**
+	 * @brief Cancels all uploads
+	 */
+	void cancelAll();
+
+signals:
+	/**
+	 * @brief Emitted while uploading
+	 * @param id the id of the upload
+	 * @param bytesSent the number of bytes sent
+	 * @param bytesTotal the number of total bytes
+	 */
+	void progress(int id, qint64 bytesSent, qint64 bytesTotal);
+
+	/**
+	 * @brief Emitted if an upload has finished
+	 * @param id the id of the upload
+	 * @param asset the asset as reported by GitHub
+	 */
+	void uploaded(int id, const QVariantMap &asset);
+
+	/**
+	 * @brief Emitted if an upload has failed or got canceled
+	 * @param id the id of the upload
+	 * @param error the error string
+	 */
+	void error(int id, const QString &error);
+
+	/**
+	 * @brief Emitted if no more uploads are queued or running
+	 */
+	void finished();
+
+private slots:
+	void replyFinished();
+	void uploadProgress(qint64, qint64);
+	void schedule();
+	void watchdog();
+
+private:
+	struct Job;
+
+	bool start(Job *job);
+	void done(Job *job, const QString &err, const QVariantMap &asset = QVariantMap());
+
+private:
+	const QByteArray m_token;
+	int m_maxParallel;
+	int m_nextId;
+	QQueue<Job *> m_queue;
+	QHash<QNetworkReply *, Job *> m_running;
+	QTimer m_watchdog;
+};
+
+#endif // QGITHUBRELEASEUPLOADER_H
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qgithubreleasewatcher.h"
+
+QGitHubReleaseWatcher::QGitHubReleaseWatcher(const QString &user, const QString &repo,
+											 QGitHubReleaseAPI::TYPE type, int perPage,
+											 QObject *p) : QObject(p),
+	m_api(new QGitHubReleaseAPI(user, repo, perPage, type, this)), m_timer(), m_revisions(),
+	m_pending(true) {
+	init();
+}
+
+QGitHubReleaseWatcher::QGitHubReleaseWatcher(const QUrl &apiUrl, QGitHubReleaseAPI::TYPE type,
+											 QObject *p) : QObject(p),
+	m_api(new QGitHubReleaseAPI(apiUrl, type, true, this)), m_timer(), m_revisions(),
+	m_pending(true) {
+	init();
+}
+
+QGitHubReleaseWatcher::~QGitHubReleaseWatcher() {}
+
+void QGitHubReleaseWatcher::init() {
+
+	QObject::connect(m_api, SIGNAL(available(QGitHubReleaseAPI)),
+					 this, SLOT(apiAvailable(QGitHubReleaseAPI)));
+	QObject::connect(m_api, SIGNAL(notModified()), this, SLOT(apiNotModified()));
+	QObject::connect(m_api, SIGNAL(error(QString)), this, SLOT(apiError(QString)));
+	QObject::connect(m_api, SIGNAL(canceled()), this, SLOT(apiCanceled()));
+	QObject::connect(&m_timer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+const QGitHubReleaseAPI &QGitHubReleaseWatcher::api() const {
+	return *m_api;
+}
+
+int QGitHubReleaseWatcher::interval() const {
+	return m_timer.isActive() ? m_timer.interval() : 0;
+}
+
+void QGitHubReleaseWatcher::setInterval(int msec) {
+
+	if(msec > 0) {
+		m_timer.start(msec);
+	} else {
+		m_timer.stop();
+	}
+}
+
+void QGitHubReleaseWatcher::poll() {
+
+	if(!m_pending) {
+		m_pending = true;
+		m_api->refresh();
+	}
+}
+
+uint QGitHubReleaseWatcher::revision(const QVariantMap &entry) {
+
+	const QVariant &updatedAt(entry.value("updated_at"));
+
+	if(!updatedAt.isNull()) return qHash(updatedAt.toString());
+
+	static const char *fields[] = {
+		"name", "tag_name", "target_commitish", "draft", "prerelease", "created_at",
+		"published_at", "body", "body_html", "body_text"
+	};
+
+	uint h = 0;
+
+	for(uint i = 0; i < sizeof(fields)/sizeof(fields[0]); ++i) {
+		h = 31 * h + qHash(entry.value(fields[i]).toString());
+	}
+
+	return h;
+}
+
+void QGitHubReleaseWatcher::apiAvailable(const QGitHubReleaseAPI &api) {
+
+	m_pending = false;
+
+	const QVariantList &entries(api.toVariantList());
+
+	QHash<ulong, uint> revisions;
+	QList<int> added, modified;
+	QList<ulong> removed;
+
+	revisions.reserve(entries.count());
+
+	for(int i = 0; i < entries.count(); ++i) {
+
+		const QVariantMap &entry(entries[i].toMap());
+		const ulong id = static_cast<ulong>(entry.value("id").toULongLong());
+		const uint rev = revision(entry);
+		const QHash<ulong, uint>::ConstIterator &prev(m_revisions.constFind(id));
+
+		revisions.insert(id, rev);
+
+		if(prev == m_revisions.constEnd()) {
+			added.append(i);
+		} else if(prev.value() != rev) {
+			modified.append(i);
+		}
+	}
+
+	for(QHash<ulong, uint>::ConstIterator i(m_revisions.constBegin());
+		i != m_revisions.constEnd(); ++i) {
+		if(!revisions.contains(i.key())) removed.append(i.key());
+	}
+
+	m_revisions = revisions;
+
+	if(added.isEmpty() && modified.isEmpty() && removed.isEmpty()) {
+		emit unchanged(api);
+	} else {
+		emit changed(api, added, modified, removed);
+	}
+}
+
+void QGitHubReleaseWatcher::apiNotModified() {
+	m_pending = false;
+	emit unchanged(*m_api);
+}
+
+void QGitHubReleaseWatcher::apiError(const QString &err) {
+	m_pending = false;
+	emit error(err);
+}
+
+void QGitHubReleaseWatcher::apiCanceled() {
+	m_pending = false;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ */
+
+#ifndef QGITHUBRELEASEWATCHER_H
+#define QGITHUBRELEASEWATCHER_H
+
+#include <QHash>
+#include <QTimer>
+
+#include "qgithubreleaseapi.h"
+
+/**
+ * @brief The @c %QGitHubReleaseWatcher class
+ *
+ * Keeps a @c QGitHubReleaseAPI alive and polls it with conditional requests.
+ * Only the releases added, modified or removed since the previous poll are
+ * reported. A poll answered with @em 304 (not modified) costs neither rate
+ * limit nor any work on the release data.
+ *
+ * Releases are identified by their @c releaseId and considered modified if
+ * their @em updated_at field or, if the API doesn't provide it, any of their
+ * name, tag, flags, dates or body changed.
+ *
+ * @author Heiko Schaefer
+ */
+class Q_DECL_EXPORT QGitHubReleaseWatcher : public QObject {
+	Q_OBJECT
+	Q_DISABLE_COPY(QGitHubReleaseWatcher)
+	Q_PROPERTY(int interval READ interval WRITE setInterval) ///< the polling interval
+
+public:
+	/**
+	 * @brief Creates an @c %QGitHubReleaseWatcher instance
+	 * @param user the GitHub user (aka login)
+	 * @param repo the repository to watch
+	 * @param type the type of the body
+	 * @param perPage the amount of releases to watch
+	 */
+	QGitHubReleaseWatcher(const QString &user, const QString &repo,
+						  QGitHubReleaseAPI::TYPE type = QGitHubReleaseAPI::RAW, int perPage = 30,
+						  QObject *parent = 0);
+
+	/**
+	 * @brief Creates an @c %QGitHubReleaseWatcher instance
+	 * @param apiUrl direct URL to watch, must return a list of releases
+	 * @param type the type of the body
+	 */
+	explicit QGitHubReleaseWatcher(const QUrl &apiUrl,
+								   QGitHubReleaseAPI::TYPE type = QGitHubReleaseAPI::RAW,
+								   QObject *parent = 0);
+
+	virtual ~QGitHubReleaseWatcher();
+
+	/**
+	 * @brief The watched @c QGitHubReleaseAPI
+	 * @return the watched @c QGitHubReleaseAPI
+	 */
+	const QGitHubReleaseAPI &api() const;
+
+	/**
+	 * @brief The polling interval
+	 * @return the polling interval in milliseconds, @c 0 if polling is manual
+	 */
+	int interval() const;
+
+	/**
+	 * @brief Sets the polling interval
+	 * @param msec the polling interval in milliseconds, @c 0 to only poll on
+	 * calling @c poll
+	 */
+	void setInterval(int msec);
+
+public slots:
+	/**
+	 * @brief Polls for changes
+	 *
+	 * Does nothing if a poll is still pending.
+	 */
+	void poll();
+
+signals:
+	/**
+	 * @brief Emitted if the releases have changed
+	 *
+	 * On the first poll all releases are reported as added.
+	 *
+	 * @param api reference to the watched @c QGitHubReleaseAPI
+	 * @param added the entry indices of the added releases
+	 * @param modified the entry indices of the modified releases
+	 * @param removed the release ids of the removed releases
+	 */
+	void changed(const QGitHubReleaseAPI &api, const QList<int> &added,
+				 const QList<int> &modified, const QList<ulong> &removed);
+
+	/**
+	 * @brief Emitted if a poll found no changes
+	 * @param api reference to the watched @c QGitHubReleaseAPI
+	 */
+	void unchanged(const QGitHubReleaseAPI &api);
+
+	/**
+	 * @brief Emitted on any error
+	 * @param error the error string
+	 */
+	void error(const QString &error);
+
+private slots:
+	void apiAvailable(const QGitHubReleaseAPI &);
+	void apiNotModified();
+	void apiError(const QString &);
+	void apiCanceled();
+
+private:
+	void init();
+	static uint revision(const QVariantMap &entry);
+
+private:
+	QGitHubReleaseAPI *const m_api;
+	QTimer m_timer;
+	QHash<ulong, uint> m_revisions;
+	bool m_pending;
+};
+
+#endif // QGITHUBRELEASEWATCHER_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtAlgorithms>
+
+#include "queryindex.h"
+#include "qgithubreleaseapi_p.h"
+
+QueryIndex::QueryIndex() : m_mutex(), m_valid(false), m_tags(), m_ids(), m_dates(),
+	m_newestRelease(-1) {}
+
+void QueryIndex::build(const QGitHubReleaseAPIPrivate &api) {
+
+	const int n = api.entries();
+
+	m_tags.clear();
+	m_ids.clear();
+	m_dates.clear();
+	m_newestRelease = -1;
+
+	m_tags.reserve(n);
+	m_ids.reserve(n);
+	m_dates.reserve(n);
+
+	QDateTime newest;
+
+	for(int i = 0; i < n; ++i) {
+
+		const QDateTime &published(api.publishedAt(i));
+
+		m_tags.insert(api.tagName(i), i);
+		m_ids.insert(api.releaseId(i), i);
+
+		if(published.isValid()) {
+
+			m_dates.append(DATEENTRY(published, i));
+
+			if((!newest.isValid() || newest < published) && !api.isDraft(i) &&
+					!api.isPreRelease(i)) {
+				newest = published;
+				m_newestRelease = i;
+			}
+		}
+	}
+
+	qSort(m_dates);
+
+	m_valid = true;
+}
+
+int QueryIndex::indexOfTag(const QGitHubReleaseAPIPrivate &api, const QString &tag) {
+
+	QMutexLocker lock(&m_mutex);
+
+	if(!m_valid) build(api);
+
+	return m_tags.value(tag, -1);
+}
+
+int QueryIndex::indexOfId(const QGitHubReleaseAPIPrivate &api, ulong id) {
+
+	QMutexLocker lock(&m_mutex);
+
+	if(!m_valid) build(api);
+
+	return m_ids.value(id, -1);
+}
+
+QList<int> QueryIndex::between(const QGitHubReleaseAPIPrivate &api, const QDateTime &from,
+							   const QDateTime &to) {
+
+	QMutexLocker lock(&m_mutex);
+
+	if(!m_valid) build(api);
+
+	QList<int> l;
+
+	for(QVector<DATEENTRY>::ConstIterator i(from.isValid() ?
+												qLowerBound(m_dates.constBegin(),
+															m_dates.constEnd(),
+															DATEENTRY(from, -1)) :
+												m_dates.constBegin());
+		i != m_dates.constEnd() && (!to.isValid() || !(to < i->first)); ++i) {
+		l.append(i->second);
+	}
+
+	return l;
+}
+
+int QueryIndex::newestRelease(const QGitHubReleaseAPIPrivate &api) {
+
+	QMutexLocker lock(&m_mutex);
+
+	if(!m_valid) build(api);
+
+	return m_newestRelease;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUERYINDEX_H
+#define QUERYINDEX_H
+
+#include <QHash>
+#include <QMutex>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QDateTime>
+
+QT_FORWARD_DECLARE_CLASS(QGitHubReleaseAPIPrivate)
+
+/**
+ * Lookup tables over the release entries
+ *
+ * Built on first query and dropped whenever the release data changes.
+ * All queries are serialised, thus the index can get shared between threads.
+ */
+class Q_DECL_HIDDEN QueryIndex {
+	Q_DISABLE_COPY(QueryIndex)
+public:
+	QueryIndex();
+
+	inline void invalidate() {
+		QMutexLocker lock(&m_mutex);
+		m_valid = false;
+	}
+
+	int indexOfTag(const QGitHubReleaseAPIPrivate &api, const QString &tag);
+	int indexOfId(const QGitHubReleaseAPIPrivate &api, ulong id);
+	QList<int> between(const QGitHubReleaseAPIPrivate &api, const QDateTime &from,
+					   const QDateTime &to);
+	int newestRelease(const QGitHubReleaseAPIPrivate &api);
+
+private:
+	void build(const QGitHubReleaseAPIPrivate &api);
+
+private:
+	typedef QPair<QDateTime, int> DATEENTRY;
+
+	QMutex m_mutex;
+	bool m_valid;
+	QHash<QString, int> m_tags;
+	QHash<ulong, int> m_ids;
+	QVector<DATEENTRY> m_dates;
+	int m_newestRelease;
+};
+
+#endif // QUERYINDEX_H
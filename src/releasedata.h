@@ -0,0 +1,62 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RELEASEDATA_H
+#define RELEASEDATA_H
+
+#include <QSharedData>
+#include <QSharedPointer>
+
+#include "qgithubreleaseapi.h"
+
+class JsonIndex;
+class ReleaseStore;
+
+/**
+ * Shared data of a QGitHubReleaseSnapshot
+ *
+ * Holds references to whatever the release information of the
+ * QGitHubReleaseAPIPrivate was kept in, thus taking it doesn't copy any entry.
+ * All of them are immutable once received, the JsonIndex locks itself.
+ */
+class Q_DECL_HIDDEN ReleaseData : public QSharedData {
+public:
+	ReleaseData(const QUrl &url, const QString &tag, QGitHubReleaseAPI::TYPE t,
+				const QVariantList &data, const QSharedPointer<JsonIndex> &index,
+				const QSharedPointer<const ReleaseStore> &store);
+	~ReleaseData();
+
+	int entries() const;
+	QVariant value(int idx, const QString &id, const QString &subId) const;
+	QVariantList toVariantList() const;
+
+	const QUrl apiUrl;
+	const QString eTag;
+	const QGitHubReleaseAPI::TYPE type;
+
+private:
+	ReleaseData &operator=(const ReleaseData &);
+
+private:
+	const QVariantList m_vdata;
+	const QSharedPointer<JsonIndex> m_jsonIndex;
+	const QSharedPointer<const ReleaseStore> m_store;
+};
+
+#endif // RELEASEDATA_H
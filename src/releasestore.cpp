@@ -0,0 +1,299 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtEndian>
+#include <QCoreApplication>
+
+#include "releasestore.h"
+
+namespace {
+
+// file header, all values little endian
+enum {
+	H_MAGIC = 0, H_VERSION = 4, H_TYPE = 6, H_ENTRIES = 8, H_RECORDSIZE = 12, H_FLAGS = 16,
+	H_HEAPOFFSET = 24, H_HEAPSIZE = 32, H_APIURL = 40, H_ETAG = 48, H_SIZE = 64
+};
+
+// record layout, strings are (offset, length) pairs into the heap
+enum {
+	R_ID = 0, R_AUTHORID = 8, R_PUBLISHED = 16, R_CREATED = 24, R_FLAGS = 32, R_STRINGS = 40
+};
+
+enum {
+	S_URL, S_ASSETS_URL, S_UPLOAD_URL, S_HTML_URL, S_NAME, S_TAG_NAME, S_TARGET_COMMITISH,
+	S_TARBALL_URL, S_ZIPBALL_URL, S_BODY, S_BODY_HTML, S_BODY_TEXT, S_LOGIN, S_AVATAR_URL,
+	S_AUTHOR_HTML_URL, S_COUNT
+};
+
+enum {
+	F_DRAFT = 1, F_PRERELEASE = 2, F_PUBLISHED = 4, F_CREATED = 8, F_SINGLE = 1
+};
+
+const quint32 RECORDSIZE = R_STRINGS + S_COUNT * 8;
+
+typedef enum { ULONG, DATE, FLAG, STRING } FIELDTYPE;
+
+const struct FIELD {
+	const char *sub;
+	const char *id;
+	FIELDTYPE type;
+	quint32 arg;
+} FIELDS[] = {
+	{ 0L, "id", ULONG, R_ID },
+	{ 0L, "published_at", DATE, F_PUBLISHED },
+	{ 0L, "created_at", DATE, F_CREATED },
+	{ 0L, "draft", FLAG, F_DRAFT },
+	{ 0L, "prerelease", FLAG, F_PRERELEASE },
+	{ 0L, "url", STRING, S_URL },
+	{ 0L, "assets_url", STRING, S_ASSETS_URL },
+	{ 0L, "upload_url", STRING, S_UPLOAD_URL },
+	{ 0L, "html_url", STRING, S_HTML_URL },
+	{ 0L, "name", STRING, S_NAME },
+	{ 0L, "tag_name", STRING, S_TAG_NAME },
+	{ 0L, "target_commitish", STRING, S_TARGET_COMMITISH },
+	{ 0L, "tarball_url", STRING, S_TARBALL_URL },
+	{ 0L, "zipball_url", STRING, S_ZIPBALL_URL },
+	{ 0L, "body", STRING, S_BODY },
+	{ 0L, "body_html", STRING, S_BODY_HTML },
+	{ 0L, "body_text", STRING, S_BODY_TEXT },
+	{ "author", "id", ULONG, R_AUTHORID },
+	{ "author", "login", STRING, S_LOGIN },
+	{ "author", "avatar_url", STRING, S_AVATAR_URL },
+	{ "author", "html_url", STRING, S_AUTHOR_HTML_URL }
+};
+
+const int FIELDCOUNT = static_cast<int>(sizeof(FIELDS)/sizeof(FIELDS[0]));
+
+void putString(uchar *dst, QByteArray &heap, const QString &str) {
+
+	const QByteArray utf8(str.toUtf8());
+
+	qToLittleEndian<quint32>(static_cast<quint32>(heap.size()), dst);
+	qToLittleEndian<quint32>(static_cast<quint32>(utf8.size()), dst + 4);
+
+	heap.append(utf8);
+}
+
+}
+
+const quint32 ReleaseStore::m_magic   = 0x51474849; // QGHI
+const quint16 ReleaseStore::m_version = 1;
+
+ReleaseStore::ReleaseStore(const QString &fileName) : m_file(fileName), m_map(0L), m_entries(0),
+	m_recordSize(0), m_heapOffset(0), m_heapSize(0), m_errorString() {
+
+	if(!m_file.open(QFile::ReadOnly) || !(m_map = m_file.map(0, m_file.size()))) {
+		m_errorString = m_file.errorString();
+		return;
+	}
+
+	const quint64 size = static_cast<quint64>(m_file.size());
+
+	if(size < H_SIZE || qFromLittleEndian<quint32>(m_map + H_MAGIC) != m_magic) {
+		m_errorString = QCoreApplication::translate("ReleaseStore", "%1: not a release index").
+				arg(fileName);
+	} else if(qFromLittleEndian<quint16>(m_map + H_VERSION) > m_version) {
+		m_errorString = QCoreApplication::translate("ReleaseStore",
+													"%1: unsupported index version %2").
+				arg(fileName).arg(qFromLittleEndian<quint16>(m_map + H_VERSION));
+	} else {
+
+		m_entries    = qFromLittleEndian<quint32>(m_map + H_ENTRIES);
+		m_recordSize = qFromLittleEndian<quint32>(m_map + H_RECORDSIZE);
+		m_heapOffset = qFromLittleEndian<quint64>(m_map + H_HEAPOFFSET);
+		m_heapSize   = qFromLittleEndian<quint64>(m_map + H_HEAPSIZE);
+
+		if(m_recordSize < RECORDSIZE ||
+				H_SIZE + static_cast<quint64>(m_entries) * m_recordSize > m_heapOffset ||
+				m_heapOffset + m_heapSize > size) {
+			m_errorString = QCoreApplication::translate("ReleaseStore", "%1: corrupt index").
+					arg(fileName);
+		}
+	}
+
+	if(!m_errorString.isNull()) {
+		m_file.unmap(m_map);
+		m_map = 0L;
+		m_entries = 0;
+	}
+}
+
+ReleaseStore::~ReleaseStore() {
+	if(m_map) m_file.unmap(m_map);
+}
+
+bool ReleaseStore::isStore(QFile &f) {
+
+	const QByteArray magic(f.peek(4));
+
+	return magic.size() == 4 &&
+			qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(magic.constData())) ==
+			m_magic;
+}
+
+bool ReleaseStore::write(QIODevice &out, const QVariantList &data, const QUrl &apiUrl,
+						 const QString &eTag, QGitHubReleaseAPI::TYPE type, bool single) {
+
+	QByteArray header(H_SIZE, 0);
+	QByteArray records(data.count() * static_cast<int>(RECORDSIZE), 0);
+	QByteArray heap;
+
+	uchar *h = reinterpret_cast<uchar *>(header.data());
+
+	putString(h + H_APIURL, heap, apiUrl.toString());
+	putString(h + H_ETAG, heap, eTag);
+
+	for(int i = 0; i < data.count(); ++i) {
+
+		const QVariantMap &entry(data[i].toMap());
+		const QVariantMap &author(entry["author"].toMap());
+
+		uchar *rec = reinterpret_cast<uchar *>(records.data()) + i * RECORDSIZE;
+		quint32 flags = 0;
+
+		for(int f = 0; f < FIELDCOUNT; ++f) {
+
+			const QVariant &v(FIELDS[f].sub ? author[FIELDS[f].id] : entry[FIELDS[f].id]);
+
+			switch(FIELDS[f].type) {
+			case ULONG:
+				qToLittleEndian<quint64>(v.toULongLong(), rec + FIELDS[f].arg);
+				break;
+			case DATE: {
+					const QDateTime &dt(v.value<QDateTime>());
+
+					if(dt.isValid()) {
+						qToLittleEndian<qint64>(dt.toMSecsSinceEpoch(), rec +
+												(FIELDS[f].arg == F_PUBLISHED ? R_PUBLISHED :
+																				R_CREATED));
+						flags |= FIELDS[f].arg;
+					}
+				} break;
+			case FLAG:
+				if(v.toBool()) flags |= FIELDS[f].arg;
+				break;
+			case STRING:
+				putString(rec + R_STRINGS + FIELDS[f].arg * 8, heap, v.toString());
+				break;
+			}
+		}
+
+		qToLittleEndian<quint32>(flags, rec + R_FLAGS);
+	}
+
+	qToLittleEndian<quint32>(m_magic, h + H_MAGIC);
+	qToLittleEndian<quint16>(m_version, h + H_VERSION);
+	qToLittleEndian<quint16>(static_cast<quint16>(type), h + H_TYPE);
+	qToLittleEndian<quint32>(static_cast<quint32>(data.count()), h + H_ENTRIES);
+	qToLittleEndian<quint32>(RECORDSIZE, h + H_RECORDSIZE);
+	qToLittleEndian<quint32>(single ? F_SINGLE : 0, h + H_FLAGS);
+	qToLittleEndian<quint64>(static_cast<quint64>(H_SIZE + records.size()), h + H_HEAPOFFSET);
+	qToLittleEndian<quint64>(static_cast<quint64>(heap.size()), h + H_HEAPSIZE);
+
+	return out.write(header) == header.size() && out.write(records) == records.size() &&
+			out.write(heap) == heap.size();
+}
+
+QString ReleaseStore::string(const uchar *str) const {
+
+	const quint64 off = qFromLittleEndian<quint32>(str);
+	const quint32 len = qFromLittleEndian<quint32>(str + 4);
+
+	if(off + len > m_heapSize) return QString::null;
+
+	return QString::fromUtf8(reinterpret_cast<const char *>(m_map + m_heapOffset + off),
+							 static_cast<int>(len));
+}
+
+QVariant ReleaseStore::field(const uchar *rec, int f) const {
+
+	const quint32 flags = qFromLittleEndian<quint32>(rec + R_FLAGS);
+
+	switch(FIELDS[f].type) {
+	case ULONG:
+		return QVariant(qFromLittleEndian<quint64>(rec + FIELDS[f].arg));
+	case DATE:
+		return (flags & FIELDS[f].arg) ?
+					QVariant(QDateTime::fromMSecsSinceEpoch(qFromLittleEndian<qint64>
+					(rec + (FIELDS[f].arg == F_PUBLISHED ? R_PUBLISHED : R_CREATED)))) :
+					QVariant();
+	case FLAG:
+		return QVariant((flags & FIELDS[f].arg) != 0);
+	case STRING:
+		return QVariant(string(rec + R_STRINGS + FIELDS[f].arg * 8));
+	}
+
+	return QVariant();
+}
+
+QVariant ReleaseStore::value(int idx, const QString &id, const QString &subId) const {
+
+	if(idx < 0 || idx >= entries()) return QVariant();
+
+	const uchar *rec = m_map + H_SIZE + static_cast<quint64>(idx) * m_recordSize;
+
+	for(int f = 0; f < FIELDCOUNT; ++f) {
+
+		if((subId.isEmpty() ? !FIELDS[f].sub : subId == QLatin1String(FIELDS[f].sub)) &&
+				id == QLatin1String(FIELDS[f].id)) {
+			return field(rec, f);
+		}
+	}
+
+	return QVariant();
+}
+
+QVariantList ReleaseStore::toVariantList() const {
+
+	QVariantList l;
+
+	for(int i = 0; i < entries(); ++i) {
+
+		const uchar *rec = m_map + H_SIZE + static_cast<quint64>(i) * m_recordSize;
+
+		QVariantMap entry, author;
+
+		for(int f = 0; f < FIELDCOUNT; ++f) {
+			(FIELDS[f].sub ? author : entry).insert(FIELDS[f].id, field(rec, f));
+		}
+
+		entry.insert("author", author);
+		l.append(entry);
+	}
+
+	return l;
+}
+
+QUrl ReleaseStore::apiUrl() const {
+	return m_map ? QUrl(string(m_map + H_APIURL)) : QUrl();
+}
+
+QString ReleaseStore::eTag() const {
+	return m_map ? string(m_map + H_ETAG) : QString::null;
+}
+
+QGitHubReleaseAPI::TYPE ReleaseStore::type() const {
+	return m_map ? static_cast<QGitHubReleaseAPI::TYPE>(qFromLittleEndian<quint16>(m_map +
+																				   H_TYPE)) :
+				   QGitHubReleaseAPI::RAW;
+}
+
+bool ReleaseStore::singleEntry() const {
+	return m_map && (qFromLittleEndian<quint32>(m_map + H_FLAGS) & F_SINGLE);
+}
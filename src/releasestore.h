@@ -0,0 +1,82 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RELEASESTORE_H
+#define RELEASESTORE_H
+
+#include <QFile>
+
+#include "qgithubreleaseapi.h"
+
+/**
+ * On-disk release index
+ *
+ * The scalar fields of every release are kept in fixed-size records, all strings
+ * (including the bodies) live in a heap addressed by offset/length pairs. The file
+ * gets memory-mapped, thus only the pages of the entries actually read are loaded.
+ */
+class Q_DECL_HIDDEN ReleaseStore {
+	Q_DISABLE_COPY(ReleaseStore)
+public:
+	explicit ReleaseStore(const QString &fileName);
+	~ReleaseStore();
+
+	static bool write(QIODevice &out, const QVariantList &data, const QUrl &apiUrl,
+					  const QString &eTag, QGitHubReleaseAPI::TYPE type, bool single);
+
+	static bool isStore(QFile &f);
+
+	inline bool isValid() const {
+		return m_map != 0L;
+	}
+
+	inline QString errorString() const {
+		return m_errorString;
+	}
+
+	inline int entries() const {
+		return static_cast<int>(m_entries);
+	}
+
+	QUrl apiUrl() const;
+	QString eTag() const;
+	QGitHubReleaseAPI::TYPE type() const;
+	bool singleEntry() const;
+
+	QVariant value(int idx, const QString &id, const QString &subId = QString::null) const;
+	QVariantList toVariantList() const;
+
+private:
+	QString string(const uchar *str) const;
+	QVariant field(const uchar *rec, int f) const;
+
+private:
+	static const quint32 m_magic;
+	static const quint16 m_version;
+
+	QFile m_file;
+	uchar *m_map;
+	quint32 m_entries;
+	quint32 m_recordSize;
+	quint64 m_heapOffset;
+	quint64 m_heapSize;
+	QString m_errorString;
+};
+
+#endif // RELEASESTORE_H
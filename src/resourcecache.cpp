@@ -0,0 +1,93 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QEventLoop>
+
+#include "resourcecache.h"
+#include "filedownloader.h"
+#include "emoji.h"
+
+ResourceCache::ResourceCache(const char *userAgent) : m_userAgent(userAgent), m_mutex(),
+	m_done(), m_data(), m_inFlight(), m_emojis(), m_emojisLoading(false), m_emojisLoaded(false) {}
+
+QByteArray ResourceCache::fetch(const QUrl &url) {
+
+	const QString &key(url.toString());
+
+	m_mutex.lock();
+
+	while(m_inFlight.contains(key)) m_done.wait(&m_mutex);
+
+	if(m_data.contains(key)) {
+		const QByteArray ba(m_data.value(key));
+		m_mutex.unlock();
+		return ba;
+	}
+
+	m_inFlight.insert(key, true);
+	m_mutex.unlock();
+
+	const QByteArray &ba(FileDownloader::fetch(url, m_userAgent));
+
+	m_mutex.lock();
+	m_data.insert(key, ba);
+	m_inFlight.remove(key);
+	m_done.wakeAll();
+	m_mutex.unlock();
+
+	return ba;
+}
+
+QUrl ResourceCache::emojiUrl(const QString &key) {
+
+	QMutexLocker lock(&m_mutex);
+
+	while(m_emojisLoading) m_done.wait(&m_mutex);
+
+	if(!m_emojisLoaded) {
+
+		m_emojisLoading = true;
+		lock.unlock();
+
+		loadEmojis();
+
+		lock.relock();
+		m_emojisLoading = false;
+		m_emojisLoaded  = true;
+		m_done.wakeAll();
+	}
+
+	return QUrl(m_emojis.value(key).toString());
+}
+
+void ResourceCache::loadEmojis() {
+
+	QEventLoop emjLoop;
+	Emoji emoji(QString::null);
+
+	QObject::connect(&emoji, SIGNAL(available()), &emjLoop, SLOT(quit()));
+	QObject::connect(&emoji, SIGNAL(error(QString)), &emjLoop, SLOT(quit()));
+
+	if(!emoji.entries()) emjLoop.exec();
+
+	const QVariantList &l(emoji.toVariantList());
+
+	// only written while m_emojisLoading is set, all readers wait for it
+	if(!l.isEmpty()) m_emojis = l.first().toMap();
+}
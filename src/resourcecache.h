@@ -0,0 +1,58 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCECACHE_H
+#define RESOURCECACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "qgithubreleaseapi.h"
+
+/**
+ * Resources shared by concurrently rendered bodies
+ *
+ * Every image and the emoji table are downloaded only once, even if requested
+ * by several threads at the same time. Late requesters wait for the download
+ * in flight instead of starting their own.
+ */
+class Q_DECL_HIDDEN ResourceCache {
+	Q_DISABLE_COPY(ResourceCache)
+public:
+	explicit ResourceCache(const char *userAgent);
+
+	QByteArray fetch(const QUrl &url);
+	QUrl emojiUrl(const QString &key);
+
+private:
+	void loadEmojis();
+
+private:
+	const char *m_userAgent;
+	QMutex m_mutex;
+	QWaitCondition m_done;
+	QHash<QString, QByteArray> m_data;
+	QHash<QString, bool> m_inFlight;
+	QVariantMap m_emojis;
+	bool m_emojisLoading;
+	bool m_emojisLoaded;
+};
+
+#endif // RESOURCECACHE_H
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QRegExp>
+
+#include "version.h"
+
+namespace {
+
+int compareIdentifier(const QString &a, const QString &b) {
+
+	bool aNum = false, bNum = false;
+
+	const qulonglong an = a.toULongLong(&aNum);
+	const qulonglong bn = b.toULongLong(&bNum);
+
+	if(aNum && bNum) return an < bn ? -1 : (bn < an ? 1 : 0);
+
+	// numeric identifiers have lower precedence than alphanumeric ones
+	if(aNum != bNum) return aNum ? -1 : 1;
+
+	return QString::compare(a, b);
+}
+
+}
+
+Version::Version() : m_numbers(), m_preRelease() {}
+
+Version::Version(const QString &tag) : m_numbers(), m_preRelease() {
+
+	const int len = tag.length();
+	int i = 0;
+
+	while(i < len && !tag[i].isDigit()) ++i;
+
+	while(i < len && tag[i].isDigit()) {
+
+		qulonglong n = 0;
+
+		while(i < len && tag[i].isDigit()) n = n * 10 + static_cast<uint>(tag[i++].digitValue());
+
+		m_numbers.append(n);
+
+		if(i + 1 < len && tag[i] == QLatin1Char('.') && tag[i + 1].isDigit()) ++i;
+		else break;
+	}
+
+	if(i < len && (tag[i] == QLatin1Char('-') || tag[i] == QLatin1Char('_') ||
+				   tag[i] == QLatin1Char('.'))) ++i;
+
+	const int plus = tag.indexOf(QLatin1Char('+'), i);
+	const QString pre(tag.mid(i, plus == -1 ? -1 : plus - i));
+
+	if(isValid() && !pre.isEmpty()) {
+		m_preRelease = pre.split(QRegExp("[._-]"), QString::SkipEmptyParts);
+	}
+}
+
+int Version::compare(const Version &o) const {
+
+	const int n = qMax(m_numbers.count(), o.m_numbers.count());
+
+	for(int i = 0; i < n; ++i) {
+
+		const qulonglong a = i < m_numbers.count() ? m_numbers[i] : 0;
+		const qulonglong b = i < o.m_numbers.count() ? o.m_numbers[i] : 0;
+
+		if(a != b) return a < b ? -1 : 1;
+	}
+
+	// a release has higher precedence than any of its pre-releases
+	if(isPreRelease() != o.isPreRelease()) return isPreRelease() ? -1 : 1;
+
+	const int p = qMin(m_preRelease.count(), o.m_preRelease.count());
+
+	for(int i = 0; i < p; ++i) {
+		const int c = compareIdentifier(m_preRelease[i], o.m_preRelease[i]);
+		if(c) return c;
+	}
+
+	return m_preRelease.count() - o.m_preRelease.count();
+}
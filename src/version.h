@@ -0,0 +1,62 @@
+/*
+ * Copyright 2015 by Heiko Schäfer <heiko@rangun.de>
+ *
+ * This file is part of QGitHubReleaseAPI.
+ *
+ * QGitHubReleaseAPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * QGitHubReleaseAPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with QGitHubReleaseAPI.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VERSION_H
+#define VERSION_H
+
+#include <QStringList>
+#include <QVector>
+
+/**
+ * Semantic (or loose) version parsed from a tag name
+ *
+ * Any leading non-digits (like @em v or @em release-) are skipped, numeric
+ * components are separated by dots and anything following them (separated by
+ * @em -, @em _ or directly attached) is taken as pre-release identifiers. Build
+ * metadata following a @em + is ignored.
+ */
+class Q_DECL_HIDDEN Version {
+public:
+	Version();
+	explicit Version(const QString &tag);
+
+	inline bool isValid() const {
+		return !m_numbers.isEmpty();
+	}
+
+	inline bool isPreRelease() const {
+		return !m_preRelease.isEmpty();
+	}
+
+	int compare(const Version &o) const;
+
+	inline bool operator<(const Version &o) const {
+		return compare(o) < 0;
+	}
+
+	inline bool operator==(const Version &o) const {
+		return compare(o) == 0;
+	}
+
+private:
+	QVector<qulonglong> m_numbers;
+	QStringList m_preRelease;
+};
+
+#endif // VERSION_H